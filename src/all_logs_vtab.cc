@@ -64,15 +64,45 @@ all_logs_vtab::get_columns(std::vector<vtab_column>& cols) const
                       "The ID for the message schema");
 }
 
-void
-all_logs_vtab::extract(std::shared_ptr<logfile> lf,
-                       uint64_t line_number,
-                       shared_buffer_ref& line,
-                       std::vector<logline_value>& values)
+const all_logs_vtab::msg_template*
+all_logs_vtab::lookup_template(const std::shared_ptr<logfile>& lf,
+                               uint64_t line_number,
+                               shared_buffer_ref& line)
 {
-    auto format = lf->get_format();
-    values.emplace_back(this->alv_value_meta, format->get_name());
+    auto ft_iter = this->alv_file_templates.find(lf.get());
+
+    if (ft_iter == this->alv_file_templates.end()
+        || ft_iter->second.ft_file.lock() != lf)
+    {
+        for (auto iter = this->alv_file_templates.begin();
+             iter != this->alv_file_templates.end();)
+        {
+            if (iter->second.ft_file.expired()) {
+                iter = this->alv_file_templates.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+
+        auto& ft = this->alv_file_templates[lf.get()];
+        ft.ft_file = lf;
+        ft.ft_lines.clear();
+        ft_iter = this->alv_file_templates.find(lf.get());
+    }
 
+    auto& lines = ft_iter->second.ft_lines;
+
+    if (lines.size() < lf->size()) {
+        lines.resize(lf->size());
+    }
+
+    auto& lt = lines[line_number];
+
+    if (lt.lt_id != 0 && lt.lt_length == line.length()) {
+        return &this->alv_templates[lt.lt_id - 1];
+    }
+
+    auto format = lf->get_format();
     std::vector<logline_value> sub_values;
 
     this->vi_attrs.clear();
@@ -91,13 +121,45 @@ all_logs_vtab::extract(std::shared_ptr<logfile> lf,
     dp.dp_msg_format = &str;
     dp.parse();
 
-    tmp_shared_buffer tsb(str.c_str());
+    auto key = std::make_pair(dp.dp_schema_id, std::move(str));
+    auto id_iter = this->alv_template_ids.find(key);
+
+    if (id_iter == this->alv_template_ids.end()) {
+        if (this->alv_templates.size() >= MAX_TEMPLATES) {
+            this->alv_uncached_template.mt_schema_id = key.first;
+            this->alv_uncached_template.mt_format = std::move(key.second);
+            return &this->alv_uncached_template;
+        }
+
+        this->alv_templates.emplace_back(msg_template{key.second, key.first});
+        id_iter = this->alv_template_ids
+                      .emplace(std::move(key), this->alv_templates.size())
+                      .first;
+    }
+
+    lt.lt_id = id_iter->second;
+    lt.lt_length = line.length();
+
+    return &this->alv_templates[lt.lt_id - 1];
+}
+
+void
+all_logs_vtab::extract(std::shared_ptr<logfile> lf,
+                       uint64_t line_number,
+                       shared_buffer_ref& line,
+                       std::vector<logline_value>& values)
+{
+    auto format = lf->get_format();
+    values.emplace_back(this->alv_value_meta, format->get_name());
+
+    const auto* mt = this->lookup_template(lf, line_number, line);
+    tmp_shared_buffer tsb(mt->mt_format.c_str(), mt->mt_format.size());
 
     values.emplace_back(this->alv_msg_meta, tsb.tsb_ref);
 
     this->alv_schema_manager.invalidate_refs();
     this->alv_schema_buffer.clear();
-    dp.dp_schema_id.to_string(std::back_inserter(this->alv_schema_buffer));
+    mt->mt_schema_id.to_string(std::back_inserter(this->alv_schema_buffer));
     shared_buffer_ref schema_ref;
     schema_ref.share(this->alv_schema_manager,
                      this->alv_schema_buffer.data(),
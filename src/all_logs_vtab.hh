@@ -31,6 +31,10 @@
 #define lnav_all_logs_vtab_hh
 
 #include <array>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "data_parser.hh"
 #include "log_vtab_impl.hh"
@@ -56,12 +60,44 @@ public:
     bool next(log_cursor& lc, logfile_sub_source& lss) override;
 
 private:
+    /**
+     * The message format and schema are the same for many messages, so they
+     * are stored once in a dictionary and each line refers to them by ID.
+     */
+    struct msg_template {
+        std::string mt_format;
+        data_parser::schema_id_t mt_schema_id;
+    };
+
+    struct line_template {
+        /** One plus the index of the template or zero if not computed. */
+        uint32_t lt_id{0};
+        /** The message length, to catch messages that are still growing. */
+        uint32_t lt_length{0};
+    };
+
+    struct file_templates {
+        std::weak_ptr<logfile> ft_file;
+        std::vector<line_template> ft_lines;
+    };
+
+    static const size_t MAX_TEMPLATES = 64 * 1024;
+
+    const msg_template* lookup_template(const std::shared_ptr<logfile>& lf,
+                                        uint64_t line_number,
+                                        shared_buffer_ref& line);
+
     logline_value_meta alv_value_meta;
     logline_value_meta alv_msg_meta;
     logline_value_meta alv_schema_meta;
     shared_buffer alv_schema_manager;
     fmt::basic_memory_buffer<char, data_parser::schema_id_t::STRING_SIZE>
         alv_schema_buffer;
+    std::vector<msg_template> alv_templates;
+    std::map<std::pair<data_parser::schema_id_t, std::string>, uint32_t>
+        alv_template_ids;
+    std::unordered_map<const logfile*, file_templates> alv_file_templates;
+    msg_template alv_uncached_template;
 };
 
 #endif  // LNAV_ALL_LOGS_VTAB_HH
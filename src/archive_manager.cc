@@ -141,6 +141,8 @@ is_archive(const fs::path& filename)
 
             static const auto RAW_FORMAT_NAME = string_fragment("raw");
             static const auto GZ_FILTER_NAME = string_fragment("gzip");
+            static const auto BZ2_FILTER_NAME = string_fragment("bzip2");
+            static const auto ZSTD_FILTER_NAME = string_fragment("zstd");
 
             format_name = archive_format_name(arc);
 
@@ -155,6 +157,19 @@ is_archive(const fs::path& filename)
                 if (filter_count == 2 && GZ_FILTER_NAME == first_filter_name) {
                     return false;
                 }
+                // The line_buffer can read these directly.
+#ifdef HAVE_BZLIB_H
+                if (filter_count == 2 && BZ2_FILTER_NAME == first_filter_name)
+                {
+                    return false;
+                }
+#endif
+#ifdef HAVE_ZSTD_H
+                if (filter_count == 2 && ZSTD_FILTER_NAME == first_filter_name)
+                {
+                    return false;
+                }
+#endif
             }
             log_info(
                 "detected archive: %s -- %s", filename.c_str(), format_name);
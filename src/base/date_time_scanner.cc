@@ -34,6 +34,7 @@
 #include "date_time_scanner.hh"
 
 #include "config.h"
+#include "perf_stats.hh"
 #include "ptimec.hh"
 
 size_t
@@ -95,11 +96,22 @@ date_time_scanner::scan(const char* time_dest,
     bool found = false;
     const char* retval = nullptr;
 
+    lnav::perf::add(lnav::perf::counter_t::TIME_PARSES);
     if (!time_fmt) {
         time_fmt = PTIMEC_FORMAT_STR;
     }
 
-    while (next_format(time_fmt, curr_time_fmt, this->dts_fmt_lock)) {
+    if (this->scan_memo(
+            time_dest, time_len, time_fmt, convert_local, tm_out, tv_out))
+    {
+        retval = &time_dest[this->dts_memo_len];
+        this->dts_fmt_len = this->dts_memo_len;
+        found = true;
+    }
+
+    while (!found
+           && next_format(time_fmt, curr_time_fmt, this->dts_fmt_lock))
+    {
         *tm_out = this->dts_base_tm;
         tm_out->et_flags = 0;
         if (time_len > 1 && time_dest[0] == '+' && isdigit(time_dest[1])) {
@@ -160,6 +172,12 @@ date_time_scanner::scan(const char* time_dest,
 
                 this->dts_fmt_lock = curr_time_fmt;
                 this->dts_fmt_len = retval - time_dest;
+                this->save_memo(time_dest,
+                                this->dts_fmt_len,
+                                time_fmt,
+                                convert_local,
+                                *tm_out,
+                                tv_out);
 
                 found = true;
                 break;
@@ -200,6 +218,12 @@ date_time_scanner::scan(const char* time_dest,
 
                 this->dts_fmt_lock = curr_time_fmt;
                 this->dts_fmt_len = retval - time_dest;
+                this->save_memo(time_dest,
+                                this->dts_fmt_len,
+                                time_fmt,
+                                convert_local,
+                                *tm_out,
+                                tv_out);
 
                 found = true;
                 break;
@@ -247,6 +271,177 @@ date_time_scanner::scan(const char* time_dest,
     return retval;
 }
 
+bool
+date_time_scanner::scan_memo(const char* time_src,
+                             size_t time_len,
+                             const char* const time_fmt[],
+                             bool convert_local,
+                             struct exttm* tm_out,
+                             struct timeval& tv_out)
+{
+    if (this->dts_memo_len == 0 || this->dts_fmt_lock == -1
+        || this->dts_memo_fmt_lock != this->dts_fmt_lock
+        || this->dts_memo_fmt != time_fmt
+        || this->dts_memo_convert_local != convert_local
+        || this->dts_memo_local_time != this->dts_local_time
+        || this->dts_memo_keep_base_tz != this->dts_keep_base_tz
+        || time_len < this->dts_memo_len)
+    {
+        return false;
+    }
+
+    /* Custom formats are only accepted if followed by a fraction or the end. */
+    if (time_fmt != PTIMEC_FORMAT_STR && time_len > this->dts_memo_len
+        && time_src[this->dts_memo_len] != '.'
+        && time_src[this->dts_memo_len] != ',')
+    {
+        return false;
+    }
+
+    if (memcmp(time_src, this->dts_memo_src, this->dts_memo_len) == 0) {
+        *tm_out = this->dts_memo_tm;
+        tv_out = this->dts_memo_tv;
+        return true;
+    }
+
+    if (this->dts_memo_min_off == -1 || this->dts_memo_sec_off == -1) {
+        return false;
+    }
+
+    /*
+     * Check if only the minutes and seconds changed, in which case the
+     * memoized time can be adjusted instead of parsing from scratch.
+     */
+    char masked[MEMO_SIZE];
+
+    memcpy(masked, time_src, this->dts_memo_len);
+    for (const auto off : {this->dts_memo_min_off, this->dts_memo_sec_off}) {
+        if (!isdigit((unsigned char) masked[off])
+            || !isdigit((unsigned char) masked[off + 1]))
+        {
+            return false;
+        }
+        masked[off] = this->dts_memo_src[off];
+        masked[off + 1] = this->dts_memo_src[off + 1];
+    }
+    if (memcmp(masked, this->dts_memo_src, this->dts_memo_len) != 0) {
+        return false;
+    }
+
+    const auto* min_src = &time_src[this->dts_memo_min_off];
+    const auto* sec_src = &time_src[this->dts_memo_sec_off];
+    int min = (min_src[0] - '0') * 10 + (min_src[1] - '0');
+    int sec = (sec_src[0] - '0') * 10 + (sec_src[1] - '0');
+
+    if (min > 59 || sec > 59) {
+        return false;
+    }
+
+    *tm_out = this->dts_memo_tm;
+    tm_out->et_tm.tm_min = min;
+    tm_out->et_tm.tm_sec = sec;
+    tv_out = this->dts_memo_tv;
+    tv_out.tv_sec += (min - this->dts_memo_tm.et_tm.tm_min) * 60
+        + (sec - this->dts_memo_tm.et_tm.tm_sec);
+
+    return true;
+}
+
+void
+date_time_scanner::save_memo(const char* time_src,
+                             size_t time_len,
+                             const char* const time_fmt[],
+                             bool convert_local,
+                             const struct exttm& tm,
+                             const struct timeval& tv)
+{
+    const char* fmt = time_fmt[this->dts_fmt_lock];
+    int min_off = -1, sec_off = -1;
+    size_t off = 0;
+
+    this->dts_memo_len = 0;
+    if (time_len == 0 || time_len >= MEMO_SIZE) {
+        return;
+    }
+
+    /*
+     * Only formats made up of fixed-width fields can be memoized since the
+     * parse of a variable-width field might change with the text after it.
+     */
+    for (size_t lpc = 0; fmt[lpc]; lpc++) {
+        if (fmt[lpc] != '%') {
+            off += 1;
+            continue;
+        }
+
+        lpc += 1;
+        switch (fmt[lpc]) {
+            case 'Y':
+                off += 4;
+                break;
+            case 'L':
+                off += 3;
+                break;
+            case 'f':
+                off += 6;
+                break;
+            case 'M':
+                min_off = off;
+                off += 2;
+                break;
+            case 'S':
+                sec_off = off;
+                off += 2;
+                break;
+            case 'y':
+            case 'd':
+            case 'H':
+            case 'I':
+                off += 2;
+                break;
+            case 'm':
+                /* The month can be one or two digits. */
+                if (fmt[lpc + 1] == '\0') {
+                    return;
+                }
+                if (off + 1 < time_len
+                    && isdigit((unsigned char) time_src[off + 1]))
+                {
+                    off += 2;
+                } else {
+                    off += 1;
+                }
+                break;
+            default:
+                return;
+        }
+    }
+
+    if (off != time_len) {
+        return;
+    }
+
+    if (convert_local
+        && (this->dts_local_time || tm.et_flags & ETF_EPOCH_TIME))
+    {
+        /* The UTC offset could change with the time, so no adjustments. */
+        min_off = -1;
+        sec_off = -1;
+    }
+
+    memcpy(this->dts_memo_src, time_src, time_len);
+    this->dts_memo_len = time_len;
+    this->dts_memo_fmt = time_fmt;
+    this->dts_memo_fmt_lock = this->dts_fmt_lock;
+    this->dts_memo_convert_local = convert_local;
+    this->dts_memo_local_time = this->dts_local_time;
+    this->dts_memo_keep_base_tz = this->dts_keep_base_tz;
+    this->dts_memo_min_off = min_off;
+    this->dts_memo_sec_off = sec_off;
+    this->dts_memo_tm = tm;
+    this->dts_memo_tv = tv;
+}
+
 void
 date_time_scanner::to_localtime(time_t t, exttm& tm_out)
 {
@@ -58,6 +58,7 @@ struct date_time_scanner {
         this->dts_base_tm = exttm{};
         this->dts_fmt_lock = -1;
         this->dts_fmt_len = -1;
+        this->dts_memo_len = 0;
     };
 
     /**
@@ -67,12 +68,14 @@ struct date_time_scanner {
     {
         this->dts_fmt_lock = -1;
         this->dts_fmt_len = -1;
+        this->dts_memo_len = 0;
     }
 
     void set_base_time(time_t base_time)
     {
         this->dts_base_time = base_time;
         localtime_r(&base_time, &this->dts_base_tm.et_tm);
+        this->dts_memo_len = 0;
     };
 
     /**
@@ -96,6 +99,28 @@ struct date_time_scanner {
 
     static const int EXPIRE_TIME = 15 * 60;
 
+    /**
+     * The text and result of the last successful scan with the locked format
+     * are kept so that consecutive timestamps, which are usually the same or
+     * only differ in the minutes and seconds, do not need to go through the
+     * full parser.
+     */
+    static const size_t MEMO_SIZE = 64;
+
+    char dts_memo_src[MEMO_SIZE];
+    size_t dts_memo_len{0};
+    const char* const* dts_memo_fmt{nullptr};
+    int dts_memo_fmt_lock{-1};
+    bool dts_memo_convert_local{false};
+    bool dts_memo_local_time{false};
+    bool dts_memo_keep_base_tz{false};
+    int dts_memo_min_off{-1};
+    int dts_memo_sec_off{-1};
+    struct exttm dts_memo_tm;
+    struct timeval dts_memo_tv {
+        0, 0
+    };
+
     const char* scan(const char* time_src,
                      size_t time_len,
                      const char* const time_fmt[],
@@ -108,6 +133,22 @@ struct date_time_scanner {
                  const char* const time_fmt[],
                  const struct exttm& tm) const;
 
+private:
+    bool scan_memo(const char* time_src,
+                   size_t time_len,
+                   const char* const time_fmt[],
+                   bool convert_local,
+                   struct exttm* tm_out,
+                   struct timeval& tv_out);
+
+    void save_memo(const char* time_src,
+                   size_t time_len,
+                   const char* const time_fmt[],
+                   bool convert_local,
+                   const struct exttm& tm,
+                   const struct timeval& tv);
+
+public:
     bool convert_to_timeval(const char* time_src,
                             ssize_t time_len,
                             const char* const time_fmt[],
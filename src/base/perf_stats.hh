@@ -0,0 +1,192 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef lnav_perf_stats_hh
+#define lnav_perf_stats_hh
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace lnav {
+namespace perf {
+
+/**
+ * The hot-path stages that are counted.  The counters are always enabled
+ * and are cheap enough to bump from any thread.
+ */
+enum class counter_t {
+    BYTES_READ,
+    LINES_INDEXED,
+    FORMAT_DETECTIONS,
+    REGEX_EVALS,
+    FILTER_EVALS,
+    TIME_PARSES,
+    INDEX_REBUILDS,
+    FRAME_RENDERS,
+    SQL_QUERIES,
+    SQL_ROWS_SCANNED,
+};
+
+struct counter_info {
+    counter_t ci_id;
+    const char* ci_name;
+    const char* ci_description;
+};
+
+static constexpr size_t COUNTER_COUNT = 10;
+
+/**
+ * Durations are kept in power-of-two buckets of microseconds, bucket N
+ * holds the durations in [2^N, 2^(N+1)).
+ */
+static constexpr size_t HISTOGRAM_BUCKETS = 32;
+
+struct counter {
+    std::atomic<uint64_t> c_count;
+    std::atomic<uint64_t> c_timed_count;
+    std::atomic<uint64_t> c_total_us;
+    std::atomic<uint64_t> c_max_us;
+    std::atomic<uint64_t> c_buckets[HISTOGRAM_BUCKETS];
+
+    /**
+     * @param pct The percentile to compute, between 0 and 1.
+     * @return The upper bound of the bucket that holds the percentile,
+     * limited to the longest duration that was recorded.
+     */
+    uint64_t percentile_us(double pct) const
+    {
+        auto total = this->c_timed_count.load(std::memory_order_relaxed);
+        auto max_us = this->c_max_us.load(std::memory_order_relaxed);
+        auto target = (uint64_t) (total * pct);
+        uint64_t seen = 0;
+
+        for (size_t lpc = 0; lpc < HISTOGRAM_BUCKETS; lpc++) {
+            seen += this->c_buckets[lpc].load(std::memory_order_relaxed);
+            if (seen > target) {
+                return std::min<uint64_t>(1ULL << (lpc + 1), max_us);
+            }
+        }
+
+        return max_us;
+    }
+};
+
+inline const counter_info*
+counter_infos()
+{
+    static const counter_info retval[COUNTER_COUNT] = {
+        {counter_t::BYTES_READ, "bytes_read", "Bytes read from files"},
+        {counter_t::LINES_INDEXED, "lines_indexed", "Lines added to an index"},
+        {counter_t::FORMAT_DETECTIONS,
+         "format_detections",
+         "Attempts to match a line against a log format"},
+        {counter_t::REGEX_EVALS, "regex_evals", "Regular expression matches"},
+        {counter_t::FILTER_EVALS, "filter_evals", "Lines checked by filters"},
+        {counter_t::TIME_PARSES, "time_parses", "Timestamps parsed"},
+        {counter_t::INDEX_REBUILDS, "index_rebuilds", "Log index rebuilds"},
+        {counter_t::FRAME_RENDERS, "frame_renders", "Screen updates"},
+        {counter_t::SQL_QUERIES, "sql_queries", "SQL statements executed"},
+        {counter_t::SQL_ROWS_SCANNED,
+         "sql_rows_scanned",
+         "Rows scanned by log virtual tables"},
+    };
+
+    return retval;
+}
+
+inline counter&
+get_counter(counter_t id)
+{
+    static counter retval[COUNTER_COUNT];
+
+    return retval[(size_t) id];
+}
+
+inline void
+add(counter_t id, uint64_t amount = 1)
+{
+    get_counter(id).c_count.fetch_add(amount, std::memory_order_relaxed);
+}
+
+inline void
+add_duration(counter_t id, std::chrono::microseconds dur)
+{
+    auto& c = get_counter(id);
+    uint64_t us = dur.count() < 0 ? 0 : dur.count();
+    size_t bucket = 0;
+
+    while (bucket + 1 < HISTOGRAM_BUCKETS && (us >> (bucket + 1)) != 0) {
+        bucket += 1;
+    }
+    c.c_count.fetch_add(1, std::memory_order_relaxed);
+    c.c_timed_count.fetch_add(1, std::memory_order_relaxed);
+    c.c_total_us.fetch_add(us, std::memory_order_relaxed);
+    c.c_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    auto prev_max = c.c_max_us.load(std::memory_order_relaxed);
+    while (prev_max < us
+           && !c.c_max_us.compare_exchange_weak(
+               prev_max, us, std::memory_order_relaxed))
+    {
+    }
+}
+
+/**
+ * Records the lifetime of the object as one event for the given counter.
+ */
+class timer {
+public:
+    explicit timer(counter_t id)
+        : t_id(id), t_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    timer(const timer&) = delete;
+    timer& operator=(const timer&) = delete;
+
+    ~timer()
+    {
+        add_duration(this->t_id,
+                     std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - this->t_start));
+    }
+
+private:
+    counter_t t_id;
+    std::chrono::steady_clock::time_point t_start;
+};
+
+}  // namespace perf
+}  // namespace lnav
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef lnav_sort_util_hh
+#define lnav_sort_util_hh
+
+#include <algorithm>
+#include <future>
+#include <iterator>
+#include <vector>
+
+namespace lnav {
+namespace sorting {
+
+/**
+ * Stable sort a range by splitting it into chunks that are sorted on separate
+ * threads and then merged pairwise.  The result is the same as calling
+ * std::stable_sort() on the whole range.
+ *
+ * @param first The start of the range to sort.
+ * @param last The end of the range to sort.
+ * @param cmp The comparison function.
+ * @param chunk_count The number of chunks to sort concurrently.
+ */
+template<typename Iter, typename Compare>
+void
+parallel_stable_sort(Iter first, Iter last, Compare cmp, size_t chunk_count)
+{
+    size_t size = std::distance(first, last);
+
+    if (chunk_count <= 1 || size < chunk_count) {
+        std::stable_sort(first, last, cmp);
+        return;
+    }
+
+    auto chunk_size = (size + chunk_count - 1) / chunk_count;
+    std::vector<std::future<void>> sorters;
+
+    for (size_t start = 0; start < size; start += chunk_size) {
+        auto chunk_first = first + start;
+        auto chunk_last = first + std::min(start + chunk_size, size);
+
+        sorters.emplace_back(std::async(
+            std::launch::async, [chunk_first, chunk_last, &cmp]() {
+                std::stable_sort(chunk_first, chunk_last, cmp);
+            }));
+    }
+    for (auto& sorter : sorters) {
+        sorter.get();
+    }
+    for (auto merged_size = chunk_size; merged_size < size; merged_size *= 2) {
+        for (size_t start = 0; start + merged_size < size;
+             start += merged_size * 2)
+        {
+            auto merge_first = first + start;
+            auto merge_middle = merge_first + merged_size;
+            auto merge_last = first + std::min(start + merged_size * 2, size);
+
+            std::inplace_merge(merge_first, merge_middle, merge_last, cmp);
+        }
+    }
+}
+
+}  // namespace sorting
+}  // namespace lnav
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "base/sort_util.hh"
+
+#include "config.h"
+#include "doctest/doctest.h"
+
+TEST_CASE("parallel_stable_sort")
+{
+    using entry = std::pair<int, size_t>;
+
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<int> keys(0, 100);
+    auto key_cmp = [](const entry& lhs, const entry& rhs) {
+        return lhs.first < rhs.first;
+    };
+
+    for (size_t size : {0, 1, 7, 1000, 4099}) {
+        std::vector<entry> orig;
+
+        for (size_t lpc = 0; lpc < size; lpc++) {
+            orig.emplace_back(keys(gen), lpc);
+        }
+
+        auto expected = orig;
+        std::stable_sort(expected.begin(), expected.end(), key_cmp);
+
+        for (size_t chunk_count = 1; chunk_count <= 9; chunk_count++) {
+            auto actual = orig;
+
+            lnav::sorting::parallel_stable_sort(
+                actual.begin(), actual.end(), key_cmp, chunk_count);
+            CHECK(actual == expected);
+        }
+    }
+}
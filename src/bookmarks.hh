@@ -33,6 +33,7 @@
 #define bookmarks_hh
 
 #include <algorithm>
+#include <iterator>
 #include <map>
 #include <set>
 #include <string>
@@ -115,6 +116,13 @@ public:
 
         require(vl >= 0);
 
+        // Marks are usually added in ascending order while scanning, so
+        // avoid the binary search when the line goes at the end.
+        if (this->empty() || this->back() < vl) {
+            this->push_back(vl);
+            return this->end();
+        }
+
         lb = std::lower_bound(this->begin(), this->end(), vl);
         if (lb == this->end() || *lb != vl) {
             this->insert(lb, vl);
@@ -126,6 +134,33 @@ public:
         return retval;
     };
 
+    /**
+     * Add all of the bookmarks in another vector to this one with a single
+     * linear merge instead of one insert per line.
+     *
+     * @param other The sorted bookmarks to add.
+     */
+    void merge(const bookmark_vector& other)
+    {
+        if (other.empty()) {
+            return;
+        }
+        if (this->empty() || this->back() < other.front()) {
+            this->base_vector::insert(this->end(), other.begin(), other.end());
+            return;
+        }
+
+        base_vector merged;
+
+        merged.reserve(this->size() + other.size());
+        std::set_union(this->begin(),
+                       this->end(),
+                       other.begin(),
+                       other.end(),
+                       std::back_inserter(merged));
+        this->base_vector::swap(merged);
+    }
+
     std::pair<iterator, iterator> equal_range(LineType start, LineType stop)
     {
         auto lb = std::lower_bound(this->begin(), this->end(), start);
@@ -33,6 +33,7 @@
 
 #include "base/fs_util.hh"
 #include "base/injector.hh"
+#include "base/perf_stats.hh"
 #include "base/string_util.hh"
 #include "bound_tags.hh"
 #include "config.h"
@@ -60,14 +61,31 @@ int
 sql_progress(const struct log_cursor& lc)
 {
     static sig_atomic_t sql_counter = 0;
+    static struct timeval scan_start;
 
     size_t total = lnav_data.ld_log_source.text_line_count();
     off_t off = lc.lc_curr_line;
 
+    if (log_vtab_data.lvd_interrupted) {
+        return 1;
+    }
+
     if (off < 0) {
         return 0;
     }
 
+    // The cursor is only sampled, so count the distance it moved forward.
+    if (log_vtab_data.lvd_rows_scanned == 0) {
+        gettimeofday(&scan_start, nullptr);
+    }
+    if (log_vtab_data.lvd_last_line >= 0 && off > log_vtab_data.lvd_last_line)
+    {
+        log_vtab_data.lvd_rows_scanned += off - log_vtab_data.lvd_last_line;
+    } else if (off != log_vtab_data.lvd_last_line) {
+        log_vtab_data.lvd_rows_scanned += 1;
+    }
+    log_vtab_data.lvd_last_line = off;
+
     if (lnav_data.ld_window == nullptr) {
         return 0;
     }
@@ -77,6 +95,25 @@ sql_progress(const struct log_cursor& lc)
     }
 
     if (ui_periodic_timer::singleton().time_to_update(sql_counter)) {
+        if (lnav_data.ld_rl_view != nullptr) {
+            struct timeval now, diff;
+
+            gettimeofday(&now, nullptr);
+            timersub(&now, &scan_start, &diff);
+
+            auto elapsed_ms = diff.tv_sec * 1000 + diff.tv_usec / 1000;
+            auto rate = elapsed_ms > 0
+                ? log_vtab_data.lvd_rows_scanned * 1000 / elapsed_ms
+                : log_vtab_data.lvd_rows_scanned;
+
+            lnav_data.ld_rl_view->set_value(
+                fmt::format(FMT_STRING("Executing query ... {:L} rows so far, "
+                                       "scanned {:L} lines ({:L}/s); "
+                                       "press CTRL+C to cancel"),
+                            lnav_data.ld_db_row_source.dls_rows.size(),
+                            log_vtab_data.lvd_rows_scanned,
+                            rate));
+        }
         lnav_data.ld_bottom_source.update_loading(off, total);
         lnav_data.ld_top_source.update_time();
         lnav_data.ld_status[LNS_TOP].do_update();
@@ -101,6 +138,48 @@ sql_progress_finished()
     lnav_data.ld_views[LNV_DB].redo_search();
 }
 
+/**
+ * Show the rows received so far while a query is still running so that the
+ * results of long queries start showing up right away.
+ */
+static void
+sql_rows_progress(exec_context& ec, const std::string& sql)
+{
+    static sig_atomic_t row_counter = 0;
+
+    if (lnav_data.ld_window == nullptr || !lnav_data.ld_looping
+        || ec.ec_dry_run)
+    {
+        return;
+    }
+
+    if (!ui_periodic_timer::singleton().time_to_update(row_counter)) {
+        return;
+    }
+
+    auto& dls = lnav_data.ld_db_row_source;
+    auto& db_tc = lnav_data.ld_views[LNV_DB];
+
+    if (lnav_data.ld_rl_view != nullptr && log_vtab_data.lvd_rows_scanned == 0)
+    {
+        lnav_data.ld_rl_view->set_value(fmt::format(
+            FMT_STRING("Executing query: {} ... {:L} rows so far"),
+            sql,
+            dls.dls_rows.size()));
+    }
+
+    // Only switch views for queries typed in at the prompt.
+    if (dls.dls_rows.size() > 1 && ec.ec_source.size() == 1) {
+        ensure_view(&db_tc);
+    }
+    db_tc.reload_data();
+    if (lnav_data.ld_view_stack.top().value_or(nullptr) == &db_tc) {
+        db_tc.do_update();
+    }
+    lnav_data.ld_status[LNS_BOTTOM].do_update();
+    refresh();
+}
+
 Result<std::string, std::string> execute_from_file(
     exec_context& ec,
     const ghc::filesystem::path& path,
@@ -163,6 +242,7 @@ execute_sql(exec_context& ec, const std::string& sql, std::string& alt_msg)
 
     ec.ec_accumulator->clear();
 
+    lnav::perf::timer query_timer(lnav::perf::counter_t::SQL_QUERIES);
     std::pair<std::string, int> source = ec.ec_source.top();
     sql_progress_guard progress_guard(
         sql_progress, sql_progress_finished, source.first, source.second);
@@ -294,12 +374,20 @@ execute_sql(exec_context& ec, const std::string& sql, std::string& alt_msg)
 
                 case SQLITE_ROW:
                     ec.ec_sql_callback(ec, stmt.in());
+                    if (ec.ec_sql_callback == sql_callback) {
+                        sql_rows_progress(ec, sql);
+                    }
                     break;
 
                 default: {
                     const char* errmsg;
 
                     log_error("sqlite3_step error code: %d", retcode);
+                    if (retcode == SQLITE_INTERRUPT
+                        && log_vtab_data.lvd_interrupted)
+                    {
+                        return ec.make_error("query canceled");
+                    }
                     errmsg = sqlite3_errmsg(lnav_data.ld_db);
                     return ec.make_error("{}", errmsg);
                     break;
@@ -121,6 +121,19 @@ public:
         return this->cr_completions;
     };
 
+    /**
+     * @return The average download speed in bytes/sec over all of the
+     *   transfers done for this request.
+     */
+    double get_average_download_speed() const
+    {
+        if (this->cr_total_time <= 0.0) {
+            return 0.0;
+        }
+
+        return this->cr_total_download_size / this->cr_total_time;
+    }
+
     virtual long complete(CURLcode result)
     {
         double total_time = 0, download_size = 0, download_speed = 0;
@@ -136,6 +149,14 @@ public:
         log_debug(
             "%s: download_speed=%f", this->cr_name.c_str(), download_speed);
 
+        this->cr_total_time += total_time;
+        this->cr_total_download_size += download_size;
+        log_debug("%s: transfers=%d total_size=%f average_speed=%f",
+                  this->cr_name.c_str(),
+                  this->cr_completions,
+                  this->cr_total_download_size,
+                  this->get_average_download_speed());
+
         return -1;
     };
 
@@ -148,6 +169,8 @@ protected:
     auto_mem<CURL> cr_handle;
     char cr_error_buffer[CURL_ERROR_SIZE];
     int cr_completions;
+    double cr_total_time{0.0};
+    double cr_total_download_size{0.0};
 };
 
 class curl_looper : public isc::service<curl_looper> {
@@ -155,6 +178,13 @@ public:
     curl_looper() : cl_curl_multi(curl_multi_cleanup)
     {
         this->cl_curl_multi.reset(curl_multi_init());
+#    ifdef CURLPIPE_MULTIPLEX
+        // Share HTTP/2 connections between requests to the same host.
+        curl_multi_setopt(
+            this->cl_curl_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#    endif
+        curl_multi_setopt(
+            this->cl_curl_multi, CURLMOPT_MAX_HOST_CONNECTIONS, 4L);
     };
 
     void process_all()
@@ -327,31 +327,40 @@ file_collection::watch_logfile(const std::string& filename,
                         auto convert_res = res.unwrap();
 
                         loo2.with_fd(std::move(convert_res.cr_destination));
-                        retval.fc_child_pollers.emplace_back(child_poller{
-                            std::move(convert_res.cr_child),
-                            [filename,
-                             st,
-                             error_queue = convert_res.cr_error_queue](
-                                auto& fc, auto& child) {
-                                if (child.was_normal_exit()
-                                    && child.exit_status() == EXIT_SUCCESS) {
-                                    log_info("pcap[%d] exited normally",
-                                             child.in());
-                                    return;
-                                }
-                                log_error("pcap[%d] exited with %d",
-                                          child.in(),
-                                          child.status());
-                                fc.fc_name_to_errors.emplace(
-                                    filename,
-                                    file_error_info{
-                                        st.st_mtime,
-                                        fmt::format(
-                                            FMT_STRING("{}"),
-                                            fmt::join(*error_queue, "\n")),
-                                    });
-                            },
-                        });
+                        if (convert_res.cr_child) {
+                            retval.fc_child_pollers.emplace_back(child_poller{
+                                std::move(convert_res.cr_child.value()),
+                                [filename,
+                                 st,
+                                 error_queue = convert_res.cr_error_queue,
+                                 tmp_path = convert_res.cr_tmp_path,
+                                 cache_path = convert_res.cr_cache_path](
+                                    auto& fc, auto& child) {
+                                    if (child.was_normal_exit()
+                                        && child.exit_status() == EXIT_SUCCESS)
+                                    {
+                                        log_info("pcap[%d] exited normally",
+                                                 child.in());
+                                        pcap_manager::finish_conversion(
+                                            tmp_path, cache_path, true);
+                                        return;
+                                    }
+                                    log_error("pcap[%d] exited with %d",
+                                              child.in(),
+                                              child.status());
+                                    pcap_manager::finish_conversion(
+                                        tmp_path, cache_path, false);
+                                    fc.fc_name_to_errors.emplace(
+                                        filename,
+                                        file_error_info{
+                                            st.st_mtime,
+                                            fmt::format(
+                                                FMT_STRING("{}"),
+                                                fmt::join(*error_queue, "\n")),
+                                        });
+                                },
+                            });
+                        }
                         auto open_res = logfile::open(filename, loo2);
                         if (open_res.isOk()) {
                             retval.fc_files.push_back(open_res.unwrap());
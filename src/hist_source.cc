@@ -104,10 +104,59 @@ hist_source2::text_attrs_for_line(textview_curses& tc,
     }
 }
 
+bool
+hist_source2::set_time_slice(int64_t slice)
+{
+    if (slice == this->hs_time_slice) {
+        return true;
+    }
+
+    this->hs_time_slice = slice;
+    this->clear_buckets();
+    if (this->hs_second_buckets_overflowed) {
+        return false;
+    }
+    for (const auto& sb : this->hs_second_buckets) {
+        for (int lpc = 0; lpc < HT__MAX; lpc++) {
+            if (sb.sb_values[lpc] != 0.0) {
+                this->add_bucket_value(
+                    sb.sb_time, (hist_type_t) lpc, sb.sb_values[lpc]);
+            }
+        }
+    }
+
+    return true;
+}
+
 void
 hist_source2::add_value(time_t row,
                         hist_source2::hist_type_t htype,
                         double value)
+{
+    // Lines that are out of order within the current bucket are counted in
+    // the latest second so that the regrouping never goes backwards.
+    if (this->hs_second_buckets_overflowed) {
+    } else if (!this->hs_second_buckets.empty()
+               && row <= this->hs_second_buckets.back().sb_time)
+    {
+        this->hs_second_buckets.back().sb_values[htype] += value;
+    } else if (this->hs_second_buckets.size() >= MAX_SECOND_BUCKETS) {
+        log_info("too many seconds in the histogram, dropping the counts");
+        this->hs_second_buckets_overflowed = true;
+        this->hs_second_buckets.clear();
+        this->hs_second_buckets.shrink_to_fit();
+    } else {
+        this->hs_second_buckets.emplace_back(second_bucket_t{row, {}});
+        this->hs_second_buckets.back().sb_values[htype] += value;
+    }
+
+    this->add_bucket_value(row, htype, value);
+}
+
+void
+hist_source2::add_bucket_value(time_t row,
+                               hist_source2::hist_type_t htype,
+                               double value)
 {
     if (row < this->hs_last_row) {
         log_error("time mismatch %ld %ld", row, this->hs_last_row);
@@ -146,6 +195,14 @@ hist_source2::init()
 
 void
 hist_source2::clear()
+{
+    this->hs_second_buckets.clear();
+    this->hs_second_buckets_overflowed = false;
+    this->clear_buckets();
+}
+
+void
+hist_source2::clear_buckets()
 {
     this->hs_line_count = 0;
     this->hs_last_bucket = -1;
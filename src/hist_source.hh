@@ -334,10 +334,14 @@ public:
 
     void init();
 
-    void set_time_slice(int64_t slice)
-    {
-        this->hs_time_slice = slice;
-    };
+    /**
+     * Change the size of the buckets.  The buckets are regrouped from the
+     * per-second counts, so the log lines do not need to be indexed again.
+     *
+     * @return False if there were too many seconds to keep counts for and
+     *   the lines need to be indexed again to fill in the buckets.
+     */
+    bool set_time_slice(int64_t slice);
 
     int64_t get_time_slice() const
     {
@@ -392,6 +396,11 @@ private:
     };
 
     static const int64_t BLOCK_SIZE = 100;
+    /**
+     * The maximum number of seconds to keep counts for, about three days of
+     * logs with a message every second.
+     */
+    static const size_t MAX_SECOND_BUCKETS = 256 * 1024;
 
     struct bucket_block {
         bucket_block()
@@ -403,13 +412,26 @@ private:
         bucket_t bb_buckets[BLOCK_SIZE];
     };
 
+    /** The counts for a single second, the finest zoom level. */
+    struct second_bucket_t {
+        time_t sb_time;
+        double sb_values[HT__MAX];
+    };
+
     bucket_t& find_bucket(int64_t index);
 
+    void clear_buckets();
+
+    void add_bucket_value(time_t row, hist_type_t htype, double value);
+
     int64_t hs_time_slice{10 * 60};
     int64_t hs_line_count;
     int64_t hs_last_bucket;
     time_t hs_last_row;
     std::map<int64_t, struct bucket_block> hs_blocks;
+    std::vector<second_bucket_t> hs_second_buckets;
+    /** True if the counts were dropped for going over MAX_SECOND_BUCKETS. */
+    bool hs_second_buckets_overflowed{false};
     stacked_bar_chart<hist_type_t> hs_chart;
 };
 
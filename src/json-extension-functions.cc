@@ -30,8 +30,11 @@
  */
 
 #include <cstring>
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "base/lrucache.hpp"
 #include "config.h"
 #include "mapbox/variant.hpp"
 #include "sqlite-extension-func.hh"
@@ -248,6 +251,217 @@ gen_handle_number(void* ctx, const char* numval, size_t numlen)
     return sjo->jo_ptr_error_code == yajl_gen_status_ok;
 }
 
+/**
+ * The parse events for a JSON document, recorded so that several pointers
+ * can be looked up in the same document without parsing it again.
+ */
+class json_event_stream {
+public:
+    enum class event_type : uint8_t {
+        null_value,
+        boolean,
+        number,
+        string,
+        start_map,
+        map_key,
+        end_map,
+        start_array,
+        end_array,
+    };
+
+    struct event {
+        event_type e_type;
+        bool e_bool;
+        uint32_t e_offset;
+        uint32_t e_length;
+    };
+
+    static const yajl_callbacks callbacks;
+
+    static std::shared_ptr<json_event_stream> parse(const std::string& json);
+
+    /**
+     * Feed the recorded events to the pointer lookup, stopping as soon as
+     * the value it was looking for has been generated.
+     *
+     * @return false if one of the callbacks canceled the lookup.
+     */
+    bool replay(json_op& jo) const;
+
+    void add(event_type type, bool bool_val = false)
+    {
+        this->jes_events.emplace_back(event{type, bool_val, 0, 0});
+    }
+
+    void add(event_type type, const void* data, size_t len)
+    {
+        auto offset = (uint32_t) this->jes_text.size();
+
+        this->jes_events.emplace_back(
+            event{type, false, offset, (uint32_t) len});
+        this->jes_text.append((const char*) data, len);
+    }
+
+    std::string jes_text;
+    std::vector<event> jes_events;
+};
+
+const yajl_callbacks json_event_stream::callbacks = {
+    +[](void* ctx) {
+        ((json_event_stream*) ctx)->add(event_type::null_value);
+        return 1;
+    },
+    +[](void* ctx, int bool_val) {
+        ((json_event_stream*) ctx)->add(event_type::boolean, bool_val);
+        return 1;
+    },
+    nullptr,
+    nullptr,
+    +[](void* ctx, const char* num, size_t len) {
+        ((json_event_stream*) ctx)->add(event_type::number, num, len);
+        return 1;
+    },
+    +[](void* ctx, const unsigned char* str, size_t len) {
+        ((json_event_stream*) ctx)->add(event_type::string, str, len);
+        return 1;
+    },
+    +[](void* ctx) {
+        ((json_event_stream*) ctx)->add(event_type::start_map);
+        return 1;
+    },
+    +[](void* ctx, const unsigned char* key, size_t len) {
+        ((json_event_stream*) ctx)->add(event_type::map_key, key, len);
+        return 1;
+    },
+    +[](void* ctx) {
+        ((json_event_stream*) ctx)->add(event_type::end_map);
+        return 1;
+    },
+    +[](void* ctx) {
+        ((json_event_stream*) ctx)->add(event_type::start_array);
+        return 1;
+    },
+    +[](void* ctx) {
+        ((json_event_stream*) ctx)->add(event_type::end_array);
+        return 1;
+    },
+};
+
+std::shared_ptr<json_event_stream>
+json_event_stream::parse(const std::string& json)
+{
+    if (json.size() >= UINT32_MAX) {
+        return nullptr;
+    }
+
+    auto retval = std::make_shared<json_event_stream>();
+    auto_mem<yajl_handle_t> handle(yajl_free);
+
+    handle = yajl_alloc(&callbacks, nullptr, retval.get());
+    if (yajl_parse(
+            handle.in(), (const unsigned char*) json.c_str(), json.size())
+            != yajl_status_ok
+        || yajl_complete_parse(handle.in()) != yajl_status_ok)
+    {
+        return nullptr;
+    }
+
+    return retval;
+}
+
+bool
+json_event_stream::replay(json_op& jo) const
+{
+    const auto& cb = json_op::ptr_callbacks;
+
+    for (const auto& ev : this->jes_events) {
+        const auto* text = &this->jes_text[ev.e_offset];
+        int rc = 1;
+
+        switch (ev.e_type) {
+            case event_type::null_value:
+                rc = cb.yajl_null(&jo);
+                break;
+            case event_type::boolean:
+                rc = cb.yajl_boolean(&jo, ev.e_bool);
+                break;
+            case event_type::number:
+                rc = cb.yajl_number(&jo, text, ev.e_length);
+                break;
+            case event_type::string:
+                rc = cb.yajl_string(
+                    &jo, (const unsigned char*) text, ev.e_length);
+                break;
+            case event_type::start_map:
+                rc = cb.yajl_start_map(&jo);
+                break;
+            case event_type::map_key:
+                rc = cb.yajl_map_key(
+                    &jo, (const unsigned char*) text, ev.e_length);
+                break;
+            case event_type::end_map:
+                rc = cb.yajl_end_map(&jo);
+                break;
+            case event_type::start_array:
+                rc = cb.yajl_start_array(&jo);
+                break;
+            case event_type::end_array:
+                rc = cb.yajl_end_array(&jo);
+                break;
+        }
+
+        if (!rc) {
+            return false;
+        }
+        if (jo.jo_ptr.jp_state == json_ptr::MS_DONE) {
+            // Nothing after the value can change the result.
+            break;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Queries often call jget() several times on the same column of a row, so
+ * the events for the last few documents are kept around.
+ */
+static std::shared_ptr<json_event_stream>
+find_json_events(const char* json_in)
+{
+    static const size_t MAX_CACHED_DOCS = 8;
+    thread_local cache::lru_cache<std::string,
+                                  std::shared_ptr<json_event_stream>>
+        DOC_CACHE(MAX_CACHED_DOCS);
+
+    std::string json_str = json_in;
+    auto cached = DOC_CACHE.get(json_str);
+
+    if (cached) {
+        return cached.value();
+    }
+
+    auto retval = json_event_stream::parse(json_str);
+    if (retval != nullptr) {
+        DOC_CACHE.put(json_str, retval);
+    }
+
+    return retval;
+}
+
+static void
+ptr_lookup_canceled(sqlite3_context* context,
+                    int argc,
+                    sqlite3_value** argv,
+                    const json_op& jo)
+{
+    if (jo.jo_ptr.jp_state == json_ptr::MS_ERR_INVALID_ESCAPE) {
+        sqlite3_result_error(context, jo.jo_ptr.error_msg().c_str(), -1);
+    } else {
+        null_or_default(context, argc, argv);
+    }
+}
+
 static void
 sql_jget(sqlite3_context* context, int argc, sqlite3_value** argv)
 {
@@ -284,51 +498,50 @@ sql_jget(sqlite3_context* context, int argc, sqlite3_value** argv)
     jo.jo_ptr_callbacks.yajl_number = gen_handle_number;
     jo.jo_ptr_data = gen.get_handle();
 
-    handle.reset(yajl_alloc(&json_op::ptr_callbacks, nullptr, &jo));
-    switch (yajl_parse(
-        handle.in(), (const unsigned char*) json_in, strlen(json_in)))
-    {
-        case yajl_status_error: {
-            err = yajl_get_error(handle.in(),
-                                 0,
-                                 (const unsigned char*) json_in,
-                                 strlen(json_in));
-            sqlite3_result_error(context, (const char*) err, -1);
-            yajl_free_error(handle.in(), err);
+    auto doc = find_json_events(json_in);
+
+    if (doc != nullptr) {
+        if (!doc->replay(jo)) {
+            ptr_lookup_canceled(context, argc, argv, jo);
             return;
         }
-        case yajl_status_client_canceled:
-            if (jo.jo_ptr.jp_state == json_ptr::MS_ERR_INVALID_ESCAPE) {
-                sqlite3_result_error(
-                    context, jo.jo_ptr.error_msg().c_str(), -1);
-            } else {
-                null_or_default(context, argc, argv);
+    } else {
+        handle.reset(yajl_alloc(&json_op::ptr_callbacks, nullptr, &jo));
+        switch (yajl_parse(
+            handle.in(), (const unsigned char*) json_in, strlen(json_in)))
+        {
+            case yajl_status_error: {
+                err = yajl_get_error(handle.in(),
+                                     0,
+                                     (const unsigned char*) json_in,
+                                     strlen(json_in));
+                sqlite3_result_error(context, (const char*) err, -1);
+                yajl_free_error(handle.in(), err);
+                return;
             }
-            return;
-        default:
-            break;
-    }
-
-    switch (yajl_complete_parse(handle.in())) {
-        case yajl_status_error: {
-            err = yajl_get_error(handle.in(),
-                                 0,
-                                 (const unsigned char*) json_in,
-                                 strlen(json_in));
-            sqlite3_result_error(context, (const char*) err, -1);
-            yajl_free_error(handle.in(), err);
-            return;
+            case yajl_status_client_canceled:
+                ptr_lookup_canceled(context, argc, argv, jo);
+                return;
+            default:
+                break;
         }
-        case yajl_status_client_canceled:
-            if (jo.jo_ptr.jp_state == json_ptr::MS_ERR_INVALID_ESCAPE) {
-                sqlite3_result_error(
-                    context, jo.jo_ptr.error_msg().c_str(), -1);
-            } else {
-                null_or_default(context, argc, argv);
+
+        switch (yajl_complete_parse(handle.in())) {
+            case yajl_status_error: {
+                err = yajl_get_error(handle.in(),
+                                     0,
+                                     (const unsigned char*) json_in,
+                                     strlen(json_in));
+                sqlite3_result_error(context, (const char*) err, -1);
+                yajl_free_error(handle.in(), err);
+                return;
             }
-            return;
-        default:
-            break;
+            case yajl_status_client_canceled:
+                ptr_lookup_canceled(context, argc, argv, jo);
+                return;
+            default:
+                break;
+        }
     }
 
     switch (jo.sjo_type) {
@@ -33,6 +33,7 @@
 #include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "config.h"
@@ -41,7 +42,13 @@
 #    include <bzlib.h>
 #endif
 
+#ifdef HAVE_ZSTD_H
+#    include <zstd.h>
+#endif
+
+#include <algorithm>
 #include <set>
+#include <thread>
 
 #ifdef HAVE_X86INTRIN_H
 #    include "simdutf8check.h"
@@ -49,69 +56,13 @@
 
 #include "base/is_utf8.hh"
 #include "base/math_util.hh"
+#include "base/perf_stats.hh"
 #include "fmtlib/fmt/format.h"
 #include "line_buffer.hh"
 
 static const ssize_t DEFAULT_INCREMENT = 128 * 1024;
 static const ssize_t MAX_COMPRESSED_BUFFER_SIZE = 32 * 1024 * 1024;
 
-/*
- * XXX REMOVE ME
- *
- * The stock bzipped file code does not use pread, so we need to use a lock to
- * get exclusive access to the file.  In the future, we should just rewrite
- * the bzipped file code to use pread.
- */
-class lock_hack {
-public:
-    class guard {
-    public:
-        guard() : g_lock(lock_hack::singleton())
-        {
-            this->g_lock.lock();
-        };
-
-        ~guard()
-        {
-            this->g_lock.unlock();
-        };
-
-    private:
-        lock_hack& g_lock;
-    };
-
-    static lock_hack& singleton()
-    {
-        static lock_hack retval;
-
-        return retval;
-    };
-
-    void lock()
-    {
-        lockf(this->lh_fd, F_LOCK, 0);
-    };
-
-    void unlock()
-    {
-        lockf(this->lh_fd, F_ULOCK, 0);
-    };
-
-private:
-    lock_hack()
-    {
-        char lockname[64];
-
-        snprintf(lockname, sizeof(lockname), "/tmp/lnav.%d.lck", getpid());
-        this->lh_fd = open(lockname, O_CREAT | O_RDWR, 0600);
-        log_perror(fcntl(this->lh_fd, F_SETFD, FD_CLOEXEC));
-        unlink(lockname);
-    };
-
-    auto_fd lh_fd;
-};
-/* XXX END */
-
 static int32_t
 read_le32(const unsigned char* data)
 {
@@ -291,8 +242,535 @@ line_buffer::gz_indexed::read(void* buf, size_t offset, size_t size)
     return bytes;
 }
 
+line_buffer::indexed_decompressor::~indexed_decompressor()
+{
+    this->finish_jobs();
+}
+
+void
+line_buffer::indexed_decompressor::add_syncpoint(uint64_t source_pos,
+                                                 file_off_t offset)
+{
+    if (this->id_syncpoints.empty()
+        || this->id_syncpoints.back().sp_offset < offset)
+    {
+        this->id_syncpoints.emplace_back(syncpoint{source_pos, offset});
+    }
+}
+
+void
+line_buffer::indexed_decompressor::finish_jobs()
+{
+    for (auto& job : this->id_jobs) {
+        job.first.wait();
+    }
+    this->id_jobs.clear();
+}
+
+void
+line_buffer::indexed_decompressor::queue_jobs()
+{
+    while (!this->id_at_end && this->id_jobs.size() < this->id_max_jobs) {
+        decode_job job;
+
+        if (!this->next_job(job)) {
+            this->id_at_end = true;
+            break;
+        }
+
+        auto seg = std::make_shared<segment>();
+        this->id_jobs.emplace_back(
+            std::async(std::launch::async, [job, seg]() { return job(*seg); }),
+            seg);
+    }
+}
+
+bool
+line_buffer::indexed_decompressor::consume_job()
+{
+    this->queue_jobs();
+    if (this->id_jobs.empty()) {
+        return false;
+    }
+
+    auto job = std::move(this->id_jobs.front());
+    this->id_jobs.pop_front();
+    if (!job.first.get()) {
+        // Nothing past this point can be decoded.
+        this->finish_jobs();
+        this->id_at_end = true;
+        return false;
+    }
+
+    auto& seg = *job.second;
+    seg.s_offset = this->id_next_offset;
+    for (const auto& sp : seg.s_syncpoints) {
+        this->add_syncpoint(sp.sp_source_pos, seg.s_offset + sp.sp_offset);
+    }
+    this->id_next_offset += seg.s_data.size();
+    this->id_source_offset = seg.s_source_end;
+    this->id_current = std::move(seg);
+    this->queue_jobs();
+
+    return true;
+}
+
+bool
+line_buffer::indexed_decompressor::decode_at(file_off_t offset)
+{
+    auto sp_iter = std::upper_bound(
+        this->id_syncpoints.begin(),
+        this->id_syncpoints.end(),
+        offset,
+        [](file_off_t off, const syncpoint& sp) { return off < sp.sp_offset; });
+
+    if (sp_iter != this->id_syncpoints.begin()) {
+        --sp_iter;
+        // Restart from the syncpoint if the jobs are past the offset or if
+        // the syncpoint is closer than where the jobs are.
+        if (offset < this->id_next_offset
+            || this->id_next_offset < sp_iter->sp_offset)
+        {
+            this->finish_jobs();
+            this->restart(*sp_iter);
+            this->id_next_offset = sp_iter->sp_offset;
+            this->id_at_end = false;
+        }
+    }
+
+    while (this->consume_job()) {
+        if (this->id_current.contains(offset)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int
+line_buffer::indexed_decompressor::read(void* buf, size_t offset, size_t size)
+{
+    auto* dst = (char*) buf;
+    size_t total = 0;
+
+    while (total < size) {
+        file_off_t pos = offset + total;
+
+        if (!this->id_current.contains(pos) && !this->decode_at(pos)) {
+            break;
+        }
+
+        auto seg_off = pos - this->id_current.s_offset;
+        auto amount = std::min(size - total,
+                               this->id_current.s_data.size() - seg_off);
+
+        memcpy(&dst[total], &this->id_current.s_data[seg_off], amount);
+        total += amount;
+    }
+
+    return total;
+}
+
+#ifdef HAVE_BZLIB_H
+namespace {
+
+/**
+ * Reader for bzip2 files that uses the block boundaries as syncpoints.  The
+ * blocks in a bzip2 stream are compressed independently, so they can be
+ * decoded in parallel.  However, they are not byte-aligned, so a block is
+ * decoded by copying it into a new single-block stream.
+ */
+class bz_decompressor : public line_buffer::indexed_decompressor {
+public:
+    explicit bz_decompressor(auto_fd fd) : bd_fd(std::move(fd))
+    {
+        this->id_max_jobs
+            = std::min(std::max(1U, std::thread::hardware_concurrency()), 8U);
+        this->add_syncpoint(0, 0);
+    }
+
+    ~bz_decompressor() override
+    {
+        this->finish_jobs();
+    }
+
+protected:
+    static constexpr uint64_t BLOCK_MAGIC = 0x314159265359ULL;
+    static constexpr uint64_t EOS_MAGIC = 0x177245385090ULL;
+    static constexpr uint64_t MAGIC_BITS = 48;
+
+    bool next_job(decode_job& job_out) override;
+
+    void restart(const syncpoint& sp) override
+    {
+        this->bd_cursor = sp.sp_source_pos;
+    }
+
+private:
+    struct bit_writer {
+        void put(uint32_t value, int count)
+        {
+            this->bw_acc = (this->bw_acc << count)
+                | (value & ((1ULL << count) - 1));
+            this->bw_bits += count;
+            while (this->bw_bits >= 8) {
+                this->bw_bits -= 8;
+                this->bw_data.push_back((this->bw_acc >> this->bw_bits) & 0xff);
+            }
+        }
+
+        void flush()
+        {
+            if (this->bw_bits > 0) {
+                this->put(0, 8 - this->bw_bits);
+            }
+        }
+
+        std::vector<unsigned char> bw_data;
+        uint64_t bw_acc{0};
+        int bw_bits{0};
+    };
+
+    static uint32_t read_bits(const std::vector<unsigned char>& src,
+                              uint64_t pos,
+                              int count)
+    {
+        uint32_t retval = 0;
+
+        for (int lpc = 0; lpc < count; lpc++, pos++) {
+            retval = (retval << 1) | ((src[pos / 8] >> (7 - pos % 8)) & 1);
+        }
+
+        return retval;
+    }
+
+    bool find_marker(uint64_t bit_pos, uint64_t& pos_out, bool& eos_out) const;
+
+    bool decode_block(uint64_t start, uint64_t end, segment& seg_out) const;
+
+    auto_fd bd_fd;
+    uint64_t bd_cursor{0}; /*< The bit position in the compressed file. */
+};
+
+bool
+bz_decompressor::find_marker(uint64_t bit_pos,
+                             uint64_t& pos_out,
+                             bool& eos_out) const
+{
+    unsigned char buffer[64 * 1024];
+    auto byte_off = bit_pos / 8;
+    int skip_bits = bit_pos % 8;
+    uint64_t window = 0;
+    uint64_t bits_seen = 0;
+
+    for (;;) {
+        auto rc = pread(this->bd_fd, buffer, sizeof(buffer), byte_off);
+
+        if (rc <= 0) {
+            return false;
+        }
+
+        for (ssize_t lpc = 0; lpc < rc; lpc++) {
+            for (int bit = 7 - skip_bits; bit >= 0; bit--) {
+                window = (window << 1) | ((buffer[lpc] >> bit) & 1);
+                bits_seen += 1;
+                if (bits_seen < MAGIC_BITS) {
+                    continue;
+                }
+
+                auto marker = window & ((1ULL << MAGIC_BITS) - 1);
+                if (marker == BLOCK_MAGIC || marker == EOS_MAGIC) {
+                    pos_out = bit_pos + bits_seen - MAGIC_BITS;
+                    eos_out = marker == EOS_MAGIC;
+                    return true;
+                }
+            }
+            skip_bits = 0;
+        }
+        byte_off += rc;
+    }
+}
+
+bool
+bz_decompressor::decode_block(uint64_t start,
+                              uint64_t end,
+                              segment& seg_out) const
+{
+    auto first_byte = start / 8;
+    auto byte_count = (end + 7) / 8 - first_byte;
+    // The extra byte keeps the shifted reads below in bounds.
+    std::vector<unsigned char> src(byte_count + 1, 0);
+
+    if (pread(this->bd_fd, src.data(), byte_count, first_byte)
+        != (ssize_t) byte_count)
+    {
+        return false;
+    }
+
+    auto pos = start - first_byte * 8;
+    auto rel_end = end - first_byte * 8;
+    // The stream CRC of a single-block stream is the CRC of the block, which
+    // comes right after the block magic.
+    auto block_crc = read_bits(src, pos + MAGIC_BITS, 32);
+    int shift = pos % 8;
+    bit_writer bw;
+
+    bw.bw_data.reserve(byte_count + 16);
+    for (const auto ch : {'B', 'Z', 'h', '9'}) {
+        bw.put(ch, 8);
+    }
+    for (; pos + 8 <= rel_end; pos += 8) {
+        auto index = pos / 8;
+
+        bw.put((src[index] << shift) | (src[index + 1] >> (8 - shift)), 8);
+    }
+    if (pos < rel_end) {
+        bw.put(read_bits(src, pos, rel_end - pos), rel_end - pos);
+    }
+    bw.put(EOS_MAGIC >> 24, 24);
+    bw.put(EOS_MAGIC & 0xffffff, 24);
+    bw.put(block_crc, 32);
+    bw.flush();
+
+    bz_stream strm;
+
+    memset(&strm, 0, sizeof(strm));
+    if (BZ2_bzDecompressInit(&strm, 0, 0) != BZ_OK) {
+        return false;
+    }
+
+    auto& out = seg_out.s_data;
+    size_t out_size = 0;
+    int ret;
+
+    out.resize(byte_count * 4);
+    strm.next_in = (char*) bw.bw_data.data();
+    strm.avail_in = bw.bw_data.size();
+    do {
+        if (out_size == out.size()) {
+            out.resize(out.size() * 2);
+        }
+        strm.next_out = &out[out_size];
+        strm.avail_out = out.size() - out_size;
+        ret = BZ2_bzDecompress(&strm);
+        out_size = out.size() - strm.avail_out;
+    } while (ret == BZ_OK && (strm.avail_in > 0 || strm.avail_out == 0));
+    BZ2_bzDecompressEnd(&strm);
+    out.resize(out_size);
+
+    if (ret != BZ_STREAM_END) {
+        log_error("unable to decode bzip2 block at bit %lld -- %d",
+                  start,
+                  ret);
+        return false;
+    }
+
+    seg_out.s_syncpoints.emplace_back(syncpoint{start, 0});
+    seg_out.s_source_end = end / 8;
+
+    return true;
+}
+
+bool
+bz_decompressor::next_job(decode_job& job_out)
+{
+    uint64_t block_start, block_end;
+    bool eos;
+
+    // Skip over the end-of-stream markers and the headers between the
+    // streams of a multi-stream file.
+    do {
+        if (!this->find_marker(this->bd_cursor, block_start, eos)) {
+            return false;
+        }
+        this->bd_cursor = block_start + MAGIC_BITS;
+    } while (eos);
+
+    // XXX The magic number could show up in the compressed data, in which
+    // case the block will fail to decode and the rest of the file will not
+    // be readable.  The odds of that are about one in 2^48 per bit.
+    if (!this->find_marker(this->bd_cursor, block_end, eos)) {
+        struct stat st;
+
+        if (fstat(this->bd_fd, &st) == -1) {
+            return false;
+        }
+        block_end = st.st_size * 8;
+    }
+    this->bd_cursor = block_end;
+
+    job_out = [this, block_start, block_end](segment& seg_out) {
+        return this->decode_block(block_start, block_end, seg_out);
+    };
+
+    return true;
+}
+
+}  // namespace
+#endif
+
+#ifdef HAVE_ZSTD_H
+namespace {
+
+/**
+ * Reader for zstd files that uses the frame boundaries as syncpoints.  If
+ * the file is in the seekable format, the syncpoints for all of the frames
+ * are loaded from the seek table up front.  The frames are decoded by one
+ * job at a time since they share the decoder.
+ */
+class zstd_decompressor : public line_buffer::indexed_decompressor {
+public:
+    explicit zstd_decompressor(auto_fd fd)
+        : zd_fd(std::move(fd)), zd_dctx(ZSTD_createDCtx()),
+          zd_in_buffer(ZSTD_DStreamInSize())
+    {
+        if (this->zd_dctx == nullptr) {
+            throw std::bad_alloc();
+        }
+        this->add_syncpoint(0, 0);
+        this->read_seek_table();
+    }
+
+    ~zstd_decompressor() override
+    {
+        this->finish_jobs();
+        ZSTD_freeDCtx(this->zd_dctx);
+    }
+
+protected:
+    static constexpr size_t SEGMENT_SIZE = 1024 * 1024;
+
+    bool next_job(decode_job& job_out) override
+    {
+        job_out = [this](segment& seg_out) {
+            return this->decode_segment(seg_out);
+        };
+
+        return true;
+    }
+
+    void restart(const syncpoint& sp) override
+    {
+        ZSTD_DCtx_reset(this->zd_dctx, ZSTD_reset_session_only);
+        this->zd_in_offset = sp.sp_source_pos;
+        this->zd_in = {this->zd_in_buffer.data(), 0, 0};
+    }
+
+private:
+    void read_seek_table();
+
+    bool decode_segment(segment& seg_out);
+
+    auto_fd zd_fd;
+    ZSTD_DCtx* zd_dctx;
+    std::vector<char> zd_in_buffer;
+    ZSTD_inBuffer zd_in{nullptr, 0, 0};
+    /** The offset in the file of the data in zd_in_buffer. */
+    file_off_t zd_in_offset{0};
+};
+
+void
+zstd_decompressor::read_seek_table()
+{
+    static constexpr uint32_t SEEKABLE_MAGIC = 0x8F92EAB1;
+    static constexpr uint32_t SKIPPABLE_MAGIC = 0x184D2A5E;
+    static constexpr size_t FOOTER_SIZE = 9;
+    static constexpr size_t SKIPPABLE_HEADER_SIZE = 8;
+
+    unsigned char footer[FOOTER_SIZE];
+    struct stat st;
+
+    if (fstat(this->zd_fd, &st) == -1
+        || st.st_size < (file_off_t) (FOOTER_SIZE + SKIPPABLE_HEADER_SIZE)
+        || pread(this->zd_fd, footer, FOOTER_SIZE, st.st_size - FOOTER_SIZE)
+            != FOOTER_SIZE
+        || (uint32_t) read_le32(&footer[5]) != SEEKABLE_MAGIC)
+    {
+        return;
+    }
+
+    auto frame_count = (uint32_t) read_le32(footer);
+    auto descriptor = footer[4];
+    size_t entry_size = (descriptor & 0x80) ? 12 : 8;
+
+    if (descriptor & 0x7c) {
+        // The reserved bits are set, so we do not know this format.
+        return;
+    }
+
+    auto table_size = frame_count * entry_size;
+    auto table_start = st.st_size - (file_off_t) FOOTER_SIZE
+        - (file_off_t) table_size - (file_off_t) SKIPPABLE_HEADER_SIZE;
+    if (table_start < 0) {
+        return;
+    }
+
+    std::vector<unsigned char> table(SKIPPABLE_HEADER_SIZE + table_size);
+    if (pread(this->zd_fd, table.data(), table.size(), table_start)
+            != (ssize_t) table.size()
+        || (uint32_t) read_le32(&table[0]) != SKIPPABLE_MAGIC
+        || (uint32_t) read_le32(&table[4]) != table_size + FOOTER_SIZE)
+    {
+        return;
+    }
+
+    uint64_t source_pos = 0;
+    file_off_t offset = 0;
+    for (size_t lpc = 0; lpc < frame_count; lpc++) {
+        const auto* entry = &table[SKIPPABLE_HEADER_SIZE + lpc * entry_size];
+
+        this->add_syncpoint(source_pos, offset);
+        source_pos += (uint32_t) read_le32(&entry[0]);
+        offset += (uint32_t) read_le32(&entry[4]);
+    }
+    log_info("loaded zstd seek table with %d frames", frame_count);
+}
+
+bool
+zstd_decompressor::decode_segment(segment& seg_out)
+{
+    seg_out.s_data.resize(SEGMENT_SIZE);
+
+    ZSTD_outBuffer out = {seg_out.s_data.data(), seg_out.s_data.size(), 0};
+
+    while (out.pos < out.size) {
+        if (this->zd_in.pos == this->zd_in.size) {
+            this->zd_in_offset += this->zd_in.size;
+
+            auto rc = pread(this->zd_fd,
+                            this->zd_in_buffer.data(),
+                            this->zd_in_buffer.size(),
+                            this->zd_in_offset);
+            if (rc <= 0) {
+                break;
+            }
+            this->zd_in = {this->zd_in_buffer.data(), (size_t) rc, 0};
+        }
+
+        auto ret = ZSTD_decompressStream(this->zd_dctx, &out, &this->zd_in);
+        if (ZSTD_isError(ret)) {
+            log_error("unable to decode zstd data at %lld -- %s",
+                      this->zd_in_offset + this->zd_in.pos,
+                      ZSTD_getErrorName(ret));
+            break;
+        }
+        if (ret == 0) {
+            // The frame is done, the next one can be decoded on its own.
+            seg_out.s_syncpoints.emplace_back(syncpoint{
+                this->zd_in_offset + this->zd_in.pos, (file_off_t) out.pos});
+        }
+    }
+    seg_out.s_data.resize(out.pos);
+    seg_out.s_source_end = this->zd_in_offset + this->zd_in.pos;
+
+    return out.pos > 0;
+}
+
+}  // namespace
+#endif
+
 line_buffer::line_buffer()
-    : lb_bz_file(false), lb_compressed_offset(0), lb_file_size(-1),
+    : lb_compressed_offset(0), lb_file_size(-1),
       lb_file_offset(0), lb_file_time(0), lb_buffer_size(0),
       lb_buffer_max(DEFAULT_LINE_BUFFER_SIZE), lb_seekable(false),
       lb_last_line_offset(-1)
@@ -322,9 +800,7 @@ line_buffer::set_fd(auto_fd& fd)
         this->lb_gz_file.close();
     }
 
-    if (this->lb_bz_file) {
-        this->lb_bz_file = false;
-    }
+    this->lb_decompressor.reset();
 
     if (fd != -1) {
         /* Sync the fd's offset with the object. */
@@ -359,12 +835,13 @@ line_buffer::set_fd(auto_fd& fd)
                         = lseek(this->lb_fd, 0, SEEK_CUR);
                 }
 #ifdef HAVE_BZLIB_H
-                else if (gz_id[0] == 'B' && gz_id[1] == 'Z')
+                else if (gz_id[0] == 'B' && gz_id[1] == 'Z' && gz_id[2] == 'h')
                 {
-                    if (lseek(fd, 0, SEEK_SET) < 0) {
-                        throw error(errno);
-                    }
-                    this->lb_bz_file = true;
+                    auto_fd bzfd(dup(fd));
+
+                    log_perror(fcntl(bzfd, F_SETFD, FD_CLOEXEC));
+                    this->lb_decompressor
+                        = std::make_unique<bz_decompressor>(std::move(bzfd));
 
                     /*
                      * Loading data from a bzip2 file is pretty slow, so we try
@@ -375,6 +852,21 @@ line_buffer::set_fd(auto_fd& fd)
                     this->lb_compressed_offset = 0;
                 }
 #endif
+#ifdef HAVE_ZSTD_H
+                else if ((uint32_t) read_le32((const unsigned char*) gz_id)
+                         == ZSTD_MAGICNUMBER)
+                {
+                    auto_fd zstdfd(dup(fd));
+
+                    log_perror(fcntl(zstdfd, F_SETFD, FD_CLOEXEC));
+                    this->lb_decompressor
+                        = std::make_unique<zstd_decompressor>(
+                            std::move(zstdfd));
+                    this->resize_buffer(MAX_COMPRESSED_BUFFER_SIZE);
+
+                    this->lb_compressed_offset = 0;
+                }
+#endif
             }
             this->lb_seekable = true;
         }
@@ -389,7 +881,7 @@ line_buffer::set_fd(auto_fd& fd)
 void
 line_buffer::resize_buffer(size_t new_max)
 {
-    require(this->lb_bz_file || this->lb_gz_file
+    require(this->lb_decompressor || this->lb_gz_file
             || new_max <= MAX_LINE_BUFFER_SIZE);
 
     if (new_max > (size_t) this->lb_buffer_max) {
@@ -518,8 +1010,7 @@ line_buffer::fill_range(file_off_t start, ssize_t max_length)
                 }
             }
         }
-#ifdef HAVE_BZLIB_H
-        else if (this->lb_bz_file)
+        else if (this->lb_decompressor)
         {
             if (this->lb_file_size != (ssize_t) -1
                 && (((ssize_t) start >= this->lb_file_size)
@@ -528,54 +1019,29 @@ line_buffer::fill_range(file_off_t start, ssize_t max_length)
             {
                 rc = 0;
             } else {
-                lock_hack::guard guard;
-                char scratch[32 * 1024];
-                BZFILE* bz_file;
-                file_off_t seek_to;
-                int bzfd;
-
-                /*
-                 * Unfortunately, there is no bzseek, so we need to reopen the
-                 * file every time we want to do a read.
-                 */
-                bzfd = dup(this->lb_fd);
-                if (lseek(this->lb_fd, 0, SEEK_SET) < 0) {
-                    close(bzfd);
-                    throw error(errno);
-                }
-                if ((bz_file = BZ2_bzdopen(bzfd, "r")) == NULL) {
-                    close(bzfd);
-                    if (errno == 0) {
-                        throw std::bad_alloc();
-                    } else {
-                        throw error(errno);
-                    }
-                }
-
-                seek_to = this->lb_file_offset + this->lb_buffer_size;
-                while (seek_to > 0) {
-                    int count;
-
-                    count = BZ2_bzread(
-                        bz_file,
-                        scratch,
-                        std::min((size_t) seek_to, sizeof(scratch)));
-                    seek_to -= count;
-                }
-                rc = BZ2_bzread(bz_file,
-                                &this->lb_buffer[this->lb_buffer_size],
-                                this->lb_buffer_max - this->lb_buffer_size);
-                this->lb_compressed_offset = lseek(bzfd, 0, SEEK_SET);
-                BZ2_bzclose(bz_file);
-
-                if (rc != -1
-                    && (rc < (this->lb_buffer_max - this->lb_buffer_size))) {
+                // Only decode what was asked for since the decompressor can
+                // seek to a nearby syncpoint for the next read.  Filling the
+                // whole buffer makes random reads much more expensive.
+                ssize_t needed = start + max_length - this->lb_file_offset
+                    - this->lb_buffer_size;
+                ssize_t request = roundup_size(std::max(needed, (ssize_t) 1),
+                                               DEFAULT_INCREMENT);
+
+                request = std::min(request,
+                                   this->lb_buffer_max - this->lb_buffer_size);
+
+                rc = this->lb_decompressor->read(
+                    &this->lb_buffer[this->lb_buffer_size],
+                    this->lb_file_offset + this->lb_buffer_size,
+                    request);
+                this->lb_compressed_offset
+                    = this->lb_decompressor->get_source_offset();
+                if (rc != -1 && rc < request) {
                     this->lb_file_size
                         = (this->lb_file_offset + this->lb_buffer_size + rc);
                 }
             }
         }
-#endif
         else if (this->lb_seekable)
         {
             rc = pread(this->lb_fd,
@@ -607,7 +1073,7 @@ line_buffer::fill_range(file_off_t start, ssize_t max_length)
                     retval = true;
                 }
 
-                if (this->lb_gz_file || this->lb_bz_file) {
+                if (this->is_compressed()) {
                     /*
                      * For compressed files, increase the buffer size so we
                      * don't have to spend as much time uncompressing the data.
@@ -635,6 +1101,7 @@ line_buffer::fill_range(file_off_t start, ssize_t max_length)
 
             default:
                 this->lb_buffer_size += rc;
+                lnav::perf::add(lnav::perf::counter_t::BYTES_READ, rc);
                 retval = true;
                 break;
         }
@@ -32,7 +32,11 @@
 #ifndef line_buffer_hh
 #define line_buffer_hh
 
+#include <deque>
 #include <exception>
+#include <functional>
+#include <future>
+#include <memory>
 #include <vector>
 
 #include <errno.h>
@@ -167,6 +171,100 @@ public:
         int gz_fd = -1; /*< The file to read data from. */
     };
 
+    /**
+     * Base class for decompressors that record syncpoints where decoding can
+     * be restarted, so that reading an earlier part of the file does not
+     * have to start over from the beginning.  The compressed data is split
+     * into jobs that decode a segment of the file each.  The jobs run in the
+     * background ahead of the reader and, if the format allows it, several
+     * of them run at the same time.
+     *
+     * Subclasses must call finish_jobs() in their destructor.
+     */
+    class indexed_decompressor {
+    public:
+        virtual ~indexed_decompressor();
+
+        /**
+         * Decompress bytes from the file returning at most `size` bytes.
+         * offset is the byte-offset in the decompressed data stream.
+         */
+        int read(void* buf, size_t offset, size_t size);
+
+        /** @return The offset in the compressed file reached so far. */
+        file_off_t get_source_offset() const
+        {
+            return this->id_source_offset;
+        }
+
+        struct syncpoint {
+            /** The position in the compressed data, in decoder units. */
+            uint64_t sp_source_pos;
+            /** The offset in the decompressed data. */
+            file_off_t sp_offset;
+        };
+
+        struct segment {
+            file_off_t s_offset{0};
+            std::vector<char> s_data;
+            /** The syncpoints found by the job, relative to s_offset. */
+            std::vector<syncpoint> s_syncpoints;
+            /** The offset in the compressed file where the segment ends. */
+            file_off_t s_source_end{0};
+
+            bool contains(file_off_t off) const
+            {
+                return this->s_offset <= off
+                    && off < this->s_offset + (file_off_t) this->s_data.size();
+            }
+        };
+
+    protected:
+        using decode_job = std::function<bool(segment&)>;
+
+        /**
+         * Find the compressed data that follows the cursor and advance the
+         * cursor past it.  This is called on the reader's thread and should
+         * be quick, the decoding is done by the returned job on a background
+         * thread.
+         *
+         * @param job_out The job that decodes the data.  It should return
+         *   false if the data could not be decoded.
+         * @return False if there is no more data.
+         */
+        virtual bool next_job(decode_job& job_out) = 0;
+
+        /** Move the cursor to the given syncpoint. */
+        virtual void restart(const syncpoint& sp) = 0;
+
+        void add_syncpoint(uint64_t source_pos, file_off_t offset);
+
+        /** Wait for the jobs to finish and discard their results. */
+        void finish_jobs();
+
+        /**
+         * The number of jobs that can run at the same time.  This should be
+         * one if the jobs share decoder state.
+         */
+        size_t id_max_jobs{1};
+
+    private:
+        using pending_job
+            = std::pair<std::future<bool>, std::shared_ptr<segment>>;
+
+        void queue_jobs();
+        bool consume_job();
+        bool decode_at(file_off_t offset);
+
+        std::vector<syncpoint> id_syncpoints;
+        std::deque<pending_job> id_jobs;
+        segment id_current;
+        /** The decompressed offset where the first queued job starts. */
+        file_off_t id_next_offset{0};
+        bool id_at_end{false};
+        file_off_t id_source_offset{0};
+    };
+
     /** Construct an empty line_buffer. */
     line_buffer();
 
@@ -208,7 +306,7 @@ public:
 
     bool is_compressed() const
     {
-        return this->lb_gz_file || this->lb_bz_file;
+        return this->lb_gz_file || this->lb_decompressor;
     };
 
     file_off_t get_read_offset(file_off_t off) const
@@ -331,7 +429,8 @@ private:
 
     auto_fd lb_fd; /*< The file to read data from. */
     gz_indexed lb_gz_file; /*< File reader for gzipped files. */
-    bool lb_bz_file; /*< Flag set for bzip2 compressed files. */
+    /** File reader for bzip2 and zstd compressed files. */
+    std::unique_ptr<indexed_decompressor> lb_decompressor;
     file_off_t lb_compressed_offset; /*< The offset into the compressed file. */
 
     auto_mem<char> lb_buffer; /*< The internal buffer where data is cached */
@@ -84,6 +84,7 @@
 #include "base/isc.hh"
 #include "base/lnav_log.hh"
 #include "base/paths.hh"
+#include "base/perf_stats.hh"
 #include "base/string_util.hh"
 #include "bookmarks.hh"
 #include "bottom_status_source.hh"
@@ -107,6 +108,7 @@
 #include "log_vtab_impl.hh"
 #include "logfile.hh"
 #include "logfile_sub_source.hh"
+#include "pcap_manager.hh"
 #include "piper_proc.hh"
 #include "readline_curses.hh"
 #include "readline_highlighters.hh"
@@ -478,6 +480,9 @@ public:
     off_t lo_last_offset;
 };
 
+/** The mark generation of the log source when the histogram was built. */
+static uint64_t hist_mark_generation = 0;
+
 class hist_index_delegate : public index_delegate {
 public:
     hist_index_delegate(hist_source2& hs, textview_curses& tc)
@@ -488,6 +493,7 @@ public:
     void index_start(logfile_sub_source& lss) override
     {
         this->hid_source.clear();
+        hist_mark_generation = lss.get_mark_generation();
     };
 
     void index_line(logfile_sub_source& lss,
@@ -537,10 +543,30 @@ rebuild_hist()
     hist_source2& hs = lnav_data.ld_hist_source2;
     int zoom = lnav_data.ld_zoom_level;
 
+    // Drop the old counts first so they are not regrouped for nothing.
+    hs.clear();
     hs.set_time_slice(ZOOM_LEVELS[zoom]);
     lss.reload_index_delegate();
 }
 
+void
+zoom_hist()
+{
+    logfile_sub_source& lss = lnav_data.ld_log_source;
+    hist_source2& hs = lnav_data.ld_hist_source2;
+    int zoom = lnav_data.ld_zoom_level;
+
+    // The per-second counts include the marks, so they can only be
+    // regrouped if the marks have not changed since they were counted.
+    if (lss.get_mark_generation() != hist_mark_generation
+        || !hs.set_time_slice(ZOOM_LEVELS[zoom]))
+    {
+        rebuild_hist();
+    } else {
+        lnav_data.ld_views[LNV_HISTOGRAM].reload_data();
+    }
+}
+
 class textfile_callback {
 public:
     textfile_callback() : front_file(nullptr), front_top(-1){};
@@ -786,6 +812,13 @@ append_default_files(lnav_flags_t flag)
 static void
 sigint(int sig)
 {
+    // The first interrupt while a query is running only cancels the query.
+    if (sig == SIGINT && log_vtab_data.lvd_running
+        && !log_vtab_data.lvd_interrupted)
+    {
+        log_vtab_data.lvd_interrupted = true;
+        return;
+    }
     lnav_data.ld_looping = false;
 }
 
@@ -1692,6 +1725,7 @@ looper()
                     changes += rebuild_indexes(loop_deadline);
                     if (!changes && ui_clock::now() < loop_deadline) {
                         next_rebuild_time = ui_clock::now() + 333ms;
+                        index_vocabulary(loop_deadline);
                     }
                     if (changes && text_file_count
                         && lnav_data.ld_text_source.empty()
@@ -1708,6 +1742,7 @@ looper()
                 lnav_data.ld_files_view.set_overlay_needs_update();
             }
 
+            auto frame_start = ui_clock::now();
             lnav_data.ld_view_stack.do_update();
             lnav_data.ld_doc_view.do_update();
             lnav_data.ld_example_view.do_update();
@@ -1741,6 +1776,10 @@ looper()
                 rlc.do_update();
             }
             refresh();
+            lnav::perf::add_duration(
+                lnav::perf::counter_t::FRAME_RENDERS,
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    ui_clock::now() - frame_start));
 
             if (lnav_data.ld_session_loaded) {
                 // Only take input from the user after everything has loaded.
@@ -1970,6 +2009,7 @@ looper()
 
                     if (!ran_cleanup) {
                         archive_manager::cleanup_cache();
+                        pcap_manager::cleanup_cache();
                         tailer::cleanup_cache();
                         ran_cleanup = true;
                     }
@@ -3040,6 +3080,7 @@ SELECT tbl_name FROM sqlite_master WHERE sql LIKE 'CREATE VIRTUAL TABLE%'
                 log_info("Executing initial commands");
                 execute_init_commands(lnav_data.ld_exec_context, cmd_results);
                 archive_manager::cleanup_cache();
+                pcap_manager::cleanup_cache();
                 tailer::cleanup_cache();
                 wait_for_pipers();
                 isc::to<curl_looper&, services::curl_streamer_t>()
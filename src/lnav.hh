@@ -318,6 +318,7 @@ extern const ssize_t ZOOM_COUNT;
 #define HELP_MSG_2(x, y, msg) "Press " ANSI_BOLD(#x) "/" ANSI_BOLD(#y) " " msg
 
 void rebuild_hist();
+void zoom_hist();
 size_t rebuild_indexes(nonstd::optional<ui_clock::time_point> deadline
                        = nonstd::nullopt);
 void rebuild_indexes_repeatedly();
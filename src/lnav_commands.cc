@@ -127,16 +127,9 @@ find_arg(std::vector<std::string>& args, const std::string& flag)
 static bookmark_vector<vis_line_t>
 combined_user_marks(vis_bookmarks& vb)
 {
-    const auto& bv = vb[&textview_curses::BM_USER];
-    const auto& bv_expr = vb[&textview_curses::BM_USER_EXPR];
-    bookmark_vector<vis_line_t> retval;
+    auto retval = vb[&textview_curses::BM_USER];
 
-    for (const auto row : bv) {
-        retval.insert_once(row);
-    }
-    for (const auto row : bv_expr) {
-        retval.insert_once(row);
-    }
+    retval.merge(vb[&textview_curses::BM_USER_EXPR]);
     return retval;
 }
 
@@ -238,10 +231,10 @@ com_adjust_log_time(exec_context& ec,
 
             retval = buffer;
         } else {
+            // The file reports a new order on the next rebuild, so only its
+            // lines are spliced back into the index.
             lf->adjust_content_time(top_content, time_diff, false);
 
-            lss.set_force_rebuild();
-
             retval = "info: adjusted time";
         }
     } else {
@@ -3456,7 +3449,7 @@ com_zoom_to(exec_context& ec,
                         lnav_data.ld_views[LNV_HISTOGRAM].get_top());
                     if (old_time_opt) {
                         old_time = old_time_opt.value();
-                        rebuild_hist();
+                        zoom_hist();
                         lnav_data.ld_hist_source2.row_for_time(old_time) |
                             [](auto new_top) {
                                 lnav_data.ld_views[LNV_HISTOGRAM].set_top(
@@ -3622,6 +3615,7 @@ com_toggle_field(exec_context& ec,
                                 HELP_MSG_1(x, "to quickly show hidden fields"));
                         }
                     }
+                    lss.invalidate_render_cache();
                     tc->set_needs_update();
                 } else {
                     missing_fields.push_back(args[lpc]);
@@ -3861,6 +3855,31 @@ com_redraw(exec_context& ec,
     return Ok(std::string());
 }
 
+static Result<std::string, std::string>
+com_perf(exec_context& ec, std::string cmdline, std::vector<std::string>& args)
+{
+    static const char* PERF_QUERY = R"(
+SELECT name, count, mean_us, p50_us, p95_us, p99_us, max_us, description
+  FROM lnav_perf_stats
+)";
+
+    if (args.empty()) {
+        return Ok(std::string());
+    }
+    if (ec.ec_dry_run) {
+        return Ok(std::string());
+    }
+
+    std::string alt_msg;
+    auto retval = TRY(execute_sql(ec, PERF_QUERY, alt_msg));
+
+    if (!(lnav_data.ld_flags & LNF_HEADLESS)) {
+        ensure_view(&lnav_data.ld_views[LNV_DB]);
+    }
+
+    return Ok(retval);
+}
+
 static Result<std::string, std::string>
 com_echo(exec_context& ec, std::string cmdline, std::vector<std::string>& args)
 {
@@ -4297,7 +4316,11 @@ public:
             auto format = lf->get_format();
             shared_buffer_ref sbr;
 
-            if (!ll->is_message()) {
+            // Skip files that do not have the column without reading their
+            // lines.
+            if (!ll->is_message()
+                || format->stats_for_value(this->lsvs_colname) == nullptr)
+            {
                 continue;
             }
 
@@ -4352,7 +4375,9 @@ public:
             auto format = lf->get_format();
             shared_buffer_ref sbr;
 
-            if (!ll->is_message()) {
+            if (!ll->is_message()
+                || format->stats_for_value(this->lsvs_colname) == nullptr)
+            {
                 continue;
             }
 
@@ -5589,6 +5614,11 @@ readline_context::command_t STD_COMMANDS[] = {
      com_redraw,
 
      help_text(":redraw").with_summary("Do a full redraw of the screen")},
+    {"perf",
+     com_perf,
+
+     help_text(":perf").with_summary(
+         "Show the counters and timings for the internal processing stages")},
     {"zoom-to",
      com_zoom_to,
 
@@ -445,12 +445,11 @@ read_json_bool(yajlpp_parse_context* ypc, int val)
     return 1;
 }
 
-static int
-read_json_int(yajlpp_parse_context* ypc, long long val)
+static void
+index_json_int(json_log_userdata* jlu,
+               const intern_string_t field_name,
+               long long val)
 {
-    json_log_userdata* jlu = (json_log_userdata*) ypc->ypc_userdata;
-    const intern_string_t field_name = ypc->get_path();
-
     if (jlu->jlu_format->lf_timestamp_field == field_name) {
         long long divisor = jlu->jlu_format->elf_timestamp_divisor;
         struct timeval tv;
@@ -483,6 +482,54 @@ read_json_int(yajlpp_parse_context* ypc, long long val)
             }
         }
     }
+}
+
+static void
+index_json_double(json_log_userdata* jlu,
+                  const intern_string_t field_name,
+                  double val)
+{
+    if (jlu->jlu_format->lf_timestamp_field == field_name) {
+        double divisor = jlu->jlu_format->elf_timestamp_divisor;
+        struct timeval tv;
+
+        tv.tv_sec = val / divisor;
+        tv.tv_usec = fmod(val, divisor) * (1000000.0 / divisor);
+        jlu->jlu_base_line->set_time(tv);
+    }
+}
+
+static void
+index_json_time(json_log_userdata* jlu, const char* str, size_t len)
+{
+    struct exttm tm_out;
+    struct timeval tv_out;
+
+    jlu->jlu_format->lf_date_time.scan(
+        str, len, jlu->jlu_format->get_timestamp_formats(), &tm_out, tv_out);
+    // Leave off the machine oriented flag since we convert it anyhow
+    jlu->jlu_format->lf_timestamp_flags
+        = tm_out.et_flags & ~ETF_MACHINE_ORIENTED;
+    jlu->jlu_base_line->set_time(tv_out);
+}
+
+static void
+index_json_level(json_log_userdata* jlu, const char* str, size_t len)
+{
+    pcre_input pi(str, 0, len);
+    pcre_context::capture_t level_cap = {0, (int) len};
+
+    jlu->jlu_base_line->set_level(
+        jlu->jlu_format->convert_level(pi, &level_cap));
+}
+
+static int
+read_json_int(yajlpp_parse_context* ypc, long long val)
+{
+    json_log_userdata* jlu = (json_log_userdata*) ypc->ypc_userdata;
+    const intern_string_t field_name = ypc->get_path();
+
+    index_json_int(jlu, field_name, val);
 
     jlu->jlu_sub_line_count
         += jlu->jlu_format->value_line_count(field_name, ypc->is_level(1));
@@ -496,14 +543,7 @@ read_json_double(yajlpp_parse_context* ypc, double val)
     json_log_userdata* jlu = (json_log_userdata*) ypc->ypc_userdata;
     const intern_string_t field_name = ypc->get_path();
 
-    if (jlu->jlu_format->lf_timestamp_field == field_name) {
-        double divisor = jlu->jlu_format->elf_timestamp_divisor;
-        struct timeval tv;
-
-        tv.tv_sec = val / divisor;
-        tv.tv_usec = fmod(val, divisor) * (1000000.0 / divisor);
-        jlu->jlu_base_line->set_time(tv);
-    }
+    index_json_double(jlu, field_name, val);
 
     jlu->jlu_sub_line_count
         += jlu->jlu_format->value_line_count(field_name, ypc->is_level(1));
@@ -559,6 +599,448 @@ static struct json_path_container json_log_handlers
            .add_cb(read_json_double)
            .add_cb(read_json_field)};
 
+/**
+ * Scanner used while indexing JSON log lines that avoids the overhead of the
+ * callback-driven yajl parser.  It makes a single pass over the line to find
+ * the timestamp, level, and opid fields and to count how many lines the
+ * message will take up when displayed.  The full parse is still done by
+ * annotate() when the line is actually displayed or queried.
+ *
+ * The results must match what the json_log_handlers would produce, so the
+ * scanner gives up on anything out of the ordinary (malformed JSON, escapes
+ * in keys or in the interesting fields, deep nesting, and so on) and the
+ * caller falls back to the full parser.
+ */
+class json_fast_scanner {
+public:
+    json_fast_scanner(json_log_userdata& jlu, const char* data, size_t len)
+        : jfs_userdata(jlu), jfs_format(*jlu.jlu_format), jfs_data(data),
+          jfs_len(len), jfs_path(jlu.jlu_format->jlf_scan_path)
+    {
+    }
+
+    bool scan()
+    {
+        this->jfs_path.clear();
+        this->skip_ws();
+        if (this->jfs_off >= this->jfs_len
+            || this->jfs_data[this->jfs_off] != '{')
+        {
+            return false;
+        }
+        if (!this->scan_value(0)) {
+            return false;
+        }
+        this->skip_ws();
+
+        return this->jfs_off == this->jfs_len;
+    }
+
+private:
+    static const size_t MAX_DEPTH = 32;
+    static const size_t MAX_CACHED_FIELDS = 1024;
+    static const size_t MAX_NUMBER_LENGTH = 256;
+
+    const external_log_format::json_field_info& field_info()
+    {
+        auto& cache = this->jfs_format.jlf_field_cache;
+        auto iter = cache.find(this->jfs_path);
+
+        if (iter != cache.end()) {
+            return iter->second;
+        }
+
+        if (cache.size() >= MAX_CACHED_FIELDS) {
+            cache.clear();
+        }
+
+        external_log_format::json_field_info jfi;
+
+        jfi.jfi_name = intern_string::lookup(this->jfs_path);
+        if (!this->jfs_format.elf_level_pointer.empty()) {
+            pcre_context_static<30> pc;
+            pcre_input pi(jfi.jfi_name);
+
+            jfi.jfi_level_pointer_match
+                = this->jfs_format.elf_level_pointer.match(pc, pi);
+        }
+
+        return cache.emplace(this->jfs_path, jfi).first->second;
+    }
+
+    void skip_ws()
+    {
+        while (this->jfs_off < this->jfs_len) {
+            switch (this->jfs_data[this->jfs_off]) {
+                case ' ':
+                case '\t':
+                case '\n':
+                case '\v':
+                case '\f':
+                case '\r':
+                    this->jfs_off += 1;
+                    break;
+                default:
+                    return;
+            }
+        }
+    }
+
+    bool expect(char ch)
+    {
+        this->skip_ws();
+        if (this->jfs_off < this->jfs_len
+            && this->jfs_data[this->jfs_off] == ch)
+        {
+            this->jfs_off += 1;
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * Scan a string, the current offset should point at the opening quote.
+     *
+     * @param start_out The offset of the first character in the string.
+     * @param escaped_out Set to true if the string has any escapes.
+     * @param newlines_out The number of newlines in the decoded string.
+     */
+    bool scan_string(size_t& start_out, bool& escaped_out, long& newlines_out)
+    {
+        this->jfs_off += 1;
+        start_out = this->jfs_off;
+        escaped_out = false;
+        newlines_out = 0;
+        while (this->jfs_off < this->jfs_len) {
+            auto ch = (unsigned char) this->jfs_data[this->jfs_off];
+
+            if (ch == '"') {
+                return true;
+            }
+            if (ch < 0x20) {
+                return false;
+            }
+            if (ch == '\\') {
+                escaped_out = true;
+                this->jfs_off += 1;
+                if (this->jfs_off >= this->jfs_len) {
+                    return false;
+                }
+                switch (this->jfs_data[this->jfs_off]) {
+                    case 'n':
+                        newlines_out += 1;
+                        break;
+                    case '"':
+                    case '\\':
+                    case '/':
+                    case 'b':
+                    case 'f':
+                    case 'r':
+                    case 't':
+                        break;
+                    case 'u': {
+                        if (this->jfs_off + 4 >= this->jfs_len) {
+                            return false;
+                        }
+                        for (int lpc = 1; lpc <= 4; lpc++) {
+                            if (!isxdigit((unsigned char) this
+                                              ->jfs_data[this->jfs_off + lpc]))
+                            {
+                                return false;
+                            }
+                        }
+                        if (strncasecmp(
+                                &this->jfs_data[this->jfs_off + 1], "000a", 4)
+                            == 0)
+                        {
+                            newlines_out += 1;
+                        }
+                        this->jfs_off += 4;
+                        break;
+                    }
+                    default:
+                        return false;
+                }
+            }
+            this->jfs_off += 1;
+        }
+
+        return false;
+    }
+
+    bool scan_digits()
+    {
+        size_t start = this->jfs_off;
+
+        while (this->jfs_off < this->jfs_len
+               && isdigit((unsigned char) this->jfs_data[this->jfs_off]))
+        {
+            this->jfs_off += 1;
+        }
+
+        return this->jfs_off > start;
+    }
+
+    bool scan_number(size_t level)
+    {
+        size_t start = this->jfs_off;
+        bool is_double = false;
+        bool has_exp = false;
+
+        if (this->jfs_data[this->jfs_off] == '-') {
+            this->jfs_off += 1;
+        }
+        if (this->jfs_off < this->jfs_len
+            && this->jfs_data[this->jfs_off] == '0')
+        {
+            this->jfs_off += 1;
+        } else if (!this->scan_digits()) {
+            return false;
+        }
+        if (this->jfs_off < this->jfs_len
+            && this->jfs_data[this->jfs_off] == '.')
+        {
+            is_double = true;
+            this->jfs_off += 1;
+            if (!this->scan_digits()) {
+                return false;
+            }
+        }
+        if (this->jfs_off < this->jfs_len
+            && (this->jfs_data[this->jfs_off] == 'e'
+                || this->jfs_data[this->jfs_off] == 'E'))
+        {
+            is_double = true;
+            has_exp = true;
+            this->jfs_off += 1;
+            if (this->jfs_off < this->jfs_len
+                && (this->jfs_data[this->jfs_off] == '+'
+                    || this->jfs_data[this->jfs_off] == '-'))
+            {
+                this->jfs_off += 1;
+            }
+            if (!this->scan_digits()) {
+                return false;
+            }
+        }
+
+        size_t num_len = this->jfs_off - start;
+        if (num_len > MAX_NUMBER_LENGTH) {
+            return false;
+        }
+
+        const auto& jfi = this->field_info();
+        bool needs_value = jfi.jfi_name == this->jfs_format.lf_timestamp_field
+            || (!is_double
+                && jfi.jfi_name == this->jfs_format.elf_level_field);
+
+        // The values are only converted when they are needed or when they
+        // could overflow, which yajl treats as a parse error.
+        if (needs_value || has_exp || num_len > 18) {
+            char num_buf[num_len + 1];
+
+            memcpy(num_buf, &this->jfs_data[start], num_len);
+            num_buf[num_len] = '\0';
+            errno = 0;
+            if (is_double) {
+                double val = strtod(num_buf, nullptr);
+
+                if ((val == HUGE_VAL || val == -HUGE_VAL) && errno == ERANGE) {
+                    return false;
+                }
+                index_json_double(&this->jfs_userdata, jfi.jfi_name, val);
+            } else {
+                long long val = strtoll(num_buf, nullptr, 10);
+
+                if (errno == ERANGE) {
+                    return false;
+                }
+                index_json_int(&this->jfs_userdata, jfi.jfi_name, val);
+            }
+        }
+
+        this->jfs_userdata.jlu_sub_line_count
+            += this->jfs_format.value_line_count(jfi.jfi_name, level == 1);
+
+        return true;
+    }
+
+    bool scan_literal(const char* lit, size_t lit_len, size_t level)
+    {
+        if (this->jfs_len - this->jfs_off < lit_len
+            || strncmp(&this->jfs_data[this->jfs_off], lit, lit_len) != 0)
+        {
+            return false;
+        }
+        this->jfs_off += lit_len;
+
+        const auto& jfi = this->field_info();
+
+        this->jfs_userdata.jlu_sub_line_count
+            += this->jfs_format.value_line_count(jfi.jfi_name, level == 1);
+
+        return true;
+    }
+
+    bool scan_string_value(size_t level)
+    {
+        size_t start;
+        bool escaped;
+        long newlines;
+
+        if (!this->scan_string(start, escaped, newlines)) {
+            return false;
+        }
+
+        const auto* str = &this->jfs_data[start];
+        size_t len = this->jfs_off - start;
+        const auto& jfi = this->field_info();
+        auto* jlu = &this->jfs_userdata;
+
+        this->jfs_off += 1;
+        if (jfi.jfi_name == this->jfs_format.lf_timestamp_field) {
+            if (escaped) {
+                return false;
+            }
+            index_json_time(jlu, str, len);
+        } else if (!this->jfs_format.elf_level_pointer.empty()) {
+            if (jfi.jfi_level_pointer_match) {
+                if (escaped) {
+                    return false;
+                }
+                index_json_level(jlu, str, len);
+            }
+        } else if (jfi.jfi_name == this->jfs_format.elf_level_field) {
+            if (escaped) {
+                return false;
+            }
+            index_json_level(jlu, str, len);
+        } else if (jfi.jfi_name == this->jfs_format.elf_opid_field) {
+            if (escaped) {
+                return false;
+            }
+            jlu->jlu_base_line->set_opid(hash_str(str, len));
+        }
+
+        jlu->jlu_sub_line_count += this->jfs_format.value_line_count(
+            jfi.jfi_name, level == 1, newlines + 1);
+
+        return true;
+    }
+
+    /**
+     * @param level The number of containers that enclose this value.
+     */
+    bool scan_value(size_t level)
+    {
+        this->skip_ws();
+        if (this->jfs_off >= this->jfs_len) {
+            return false;
+        }
+
+        switch (this->jfs_data[this->jfs_off]) {
+            case '{':
+            case '[': {
+                if (level >= MAX_DEPTH) {
+                    return false;
+                }
+                if (level == 1) {
+                    this->jfs_userdata.jlu_sub_line_count
+                        += this->jfs_format.value_line_count(
+                            this->jfs_top_field, true);
+                }
+                if (this->jfs_data[this->jfs_off] == '{') {
+                    return this->scan_object(level + 1);
+                }
+                return this->scan_array(level + 1);
+            }
+            case '"':
+                return this->scan_string_value(level);
+            case 't':
+                return this->scan_literal("true", 4, level);
+            case 'f':
+                return this->scan_literal("false", 5, level);
+            case 'n':
+                return this->scan_literal("null", 4, level);
+            default:
+                if (this->jfs_data[this->jfs_off] == '-'
+                    || isdigit((unsigned char) this->jfs_data[this->jfs_off]))
+                {
+                    return this->scan_number(level);
+                }
+                return false;
+        }
+    }
+
+    bool scan_object(size_t level)
+    {
+        auto path_len = this->jfs_path.size();
+
+        this->jfs_off += 1;
+        if (this->expect('}')) {
+            return true;
+        }
+        do {
+            size_t key_start;
+            bool escaped;
+            long newlines;
+
+            this->skip_ws();
+            if (this->jfs_off >= this->jfs_len
+                || this->jfs_data[this->jfs_off] != '"'
+                || !this->scan_string(key_start, escaped, newlines) || escaped)
+            {
+                return false;
+            }
+
+            this->jfs_path.resize(path_len);
+            if (!this->jfs_path.empty() && this->jfs_path.back() != '/') {
+                this->jfs_path.push_back('/');
+            }
+            this->jfs_path.append(&this->jfs_data[key_start],
+                                  this->jfs_off - key_start);
+            this->jfs_off += 1;
+            if (level == 1) {
+                this->jfs_top_field = this->field_info().jfi_name;
+            }
+            if (!this->expect(':') || !this->scan_value(level)) {
+                return false;
+            }
+        } while (this->expect(','));
+        this->jfs_path.resize(path_len);
+
+        return this->expect('}');
+    }
+
+    bool scan_array(size_t level)
+    {
+        auto path_len = this->jfs_path.size();
+
+        this->jfs_off += 1;
+        if (this->expect(']')) {
+            return true;
+        }
+        this->jfs_path.push_back('#');
+        do {
+            if (!this->scan_value(level)) {
+                return false;
+            }
+        } while (this->expect(','));
+        this->jfs_path.resize(path_len);
+
+        return this->expect(']');
+    }
+
+    json_log_userdata& jfs_userdata;
+    external_log_format& jfs_format;
+    const char* jfs_data;
+    size_t jfs_len;
+    size_t jfs_off{0};
+    std::string& jfs_path;
+    intern_string_t jfs_top_field;
+};
+
 static int rewrite_json_field(yajlpp_parse_context* ypc,
                               const unsigned char* str,
                               size_t len);
@@ -688,22 +1170,33 @@ external_log_format::scan(logfile& lf,
 
         const auto* line_data = (const unsigned char*) sbr.get_data();
 
-        yajl_reset(handle);
-        ypc.set_static_handler(json_log_handlers.jpc_children[0]);
-        ypc.ypc_userdata = &jlu;
-        ypc.ypc_ignore_unused = true;
-        ypc.ypc_alt_callbacks.yajl_start_array = json_array_start;
-        ypc.ypc_alt_callbacks.yajl_start_map = json_array_start;
-        ypc.ypc_alt_callbacks.yajl_end_array = nullptr;
-        ypc.ypc_alt_callbacks.yajl_end_map = nullptr;
         jlu.jlu_format = this;
         jlu.jlu_base_line = &ll;
         jlu.jlu_line_value = sbr.get_data();
         jlu.jlu_line_size = sbr.length();
         jlu.jlu_handle = handle;
-        if (yajl_parse(handle, line_data, sbr.length()) == yajl_status_ok
-            && yajl_complete_parse(handle) == yajl_status_ok)
-        {
+
+        json_fast_scanner jfs(jlu, sbr.get_data(), sbr.length());
+        bool parsed = jfs.scan();
+
+        if (!parsed) {
+            // Start over with the full parser.
+            ll = logline(li.li_file_range.fr_offset, 0, 0, LEVEL_INFO);
+            jlu.jlu_sub_line_count = 1;
+
+            yajl_reset(handle);
+            ypc.set_static_handler(json_log_handlers.jpc_children[0]);
+            ypc.ypc_userdata = &jlu;
+            ypc.ypc_ignore_unused = true;
+            ypc.ypc_alt_callbacks.yajl_start_array = json_array_start;
+            ypc.ypc_alt_callbacks.yajl_start_map = json_array_start;
+            ypc.ypc_alt_callbacks.yajl_end_array = nullptr;
+            ypc.ypc_alt_callbacks.yajl_end_map = nullptr;
+            parsed = yajl_parse(handle, line_data, sbr.length())
+                    == yajl_status_ok
+                && yajl_complete_parse(handle) == yajl_status_ok;
+        }
+        if (parsed) {
             if (ll.get_time() == 0) {
                 if (this->lf_specialized) {
                     ll.set_ignore(true);
@@ -1175,37 +1668,18 @@ read_json_field(yajlpp_parse_context* ypc, const unsigned char* str, size_t len)
 {
     json_log_userdata* jlu = (json_log_userdata*) ypc->ypc_userdata;
     const intern_string_t field_name = ypc->get_path();
-    struct exttm tm_out;
-    struct timeval tv_out;
 
     if (jlu->jlu_format->lf_timestamp_field == field_name) {
-        jlu->jlu_format->lf_date_time.scan(
-            (const char*) str,
-            len,
-            jlu->jlu_format->get_timestamp_formats(),
-            &tm_out,
-            tv_out);
-        // Leave off the machine oriented flag since we convert it anyhow
-        jlu->jlu_format->lf_timestamp_flags
-            = tm_out.et_flags & ~ETF_MACHINE_ORIENTED;
-        jlu->jlu_base_line->set_time(tv_out);
+        index_json_time(jlu, (const char*) str, len);
     } else if (!jlu->jlu_format->elf_level_pointer.empty()) {
         pcre_context_static<30> pc;
         pcre_input pi(field_name);
 
         if (jlu->jlu_format->elf_level_pointer.match(pc, pi)) {
-            pcre_input pi_level((const char*) str, 0, len);
-            pcre_context::capture_t level_cap = {0, (int) len};
-
-            jlu->jlu_base_line->set_level(
-                jlu->jlu_format->convert_level(pi_level, &level_cap));
+            index_json_level(jlu, (const char*) str, len);
         }
     } else if (jlu->jlu_format->elf_level_field == field_name) {
-        pcre_input pi((const char*) str, 0, len);
-        pcre_context::capture_t level_cap = {0, (int) len};
-
-        jlu->jlu_base_line->set_level(
-            jlu->jlu_format->convert_level(pi, &level_cap));
+        index_json_level(jlu, (const char*) str, len);
     } else if (jlu->jlu_format->elf_opid_field == field_name) {
         uint8_t opid = hash_str((const char*) str, len);
         jlu->jlu_base_line->set_opid(opid);
@@ -2272,6 +2746,28 @@ public:
         return false;
     };
 
+    virtual prefetch_t can_prefetch(const logfile& lf,
+                                    const logline& ll) const
+    {
+        // JSON lines are annotated from state left behind by the parser.
+        if (this->elt_format.elf_type != external_log_format::ELF_TYPE_TEXT) {
+            return prefetch_t::STOP;
+        }
+        if (ll.is_continued()) {
+            return prefetch_t::SKIP;
+        }
+        if (lf.get_format_name() == this->lfvi_format.get_name()) {
+            return prefetch_t::EXTRACT;
+        }
+        if (ll.get_module_id() == this->lfvi_format.lf_mod_index
+            && ll.get_module_id() != 0)
+        {
+            return prefetch_t::STOP;
+        }
+
+        return prefetch_t::SKIP;
+    }
+
     virtual void extract(std::shared_ptr<logfile> lf,
                          uint64_t line_number,
                          shared_buffer_ref& line,
@@ -285,10 +285,18 @@ public:
                           const unsigned char* str = nullptr,
                           ssize_t len = -1) const
     {
-        const auto iter = this->elf_value_defs.find(ist);
         long line_count
             = (str != NULL) ? std::count(&str[0], &str[len], '\n') + 1 : 1;
 
+        return this->value_line_count(ist, top_level, line_count);
+    };
+
+    long value_line_count(const intern_string_t ist,
+                          bool top_level,
+                          long line_count) const
+    {
+        const auto iter = this->elf_value_defs.find(ist);
+
         if (iter == this->elf_value_defs.end()) {
             return (this->jlf_hide_extra || !top_level) ? 0 : line_count;
         }
@@ -469,6 +477,19 @@ public:
     std::shared_ptr<yajlpp_parse_context> jlf_parse_context;
     std::shared_ptr<yajl_handle_t> jlf_yajl_handle;
 
+    /**
+     * The parts of the format configuration that apply to a field path,
+     * cached so that the JSON indexing fast-path does not need to intern
+     * the path and match it for every line.
+     */
+    struct json_field_info {
+        intern_string_t jfi_name;
+        bool jfi_level_pointer_match{false};
+    };
+
+    std::unordered_map<std::string, json_field_info> jlf_field_cache;
+    std::string jlf_scan_path;
+
 private:
     const intern_string_t elf_name;
 
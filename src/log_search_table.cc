@@ -27,6 +27,8 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <string.h>
+
 #include "log_search_table.hh"
 
 #include "column_namer.hh"
@@ -43,6 +45,42 @@ log_search_table::log_search_table(pcrepp pattern, intern_string_t table_name)
 {
     this->vi_supports_indexes = false;
     this->get_columns_int(this->lst_cols);
+
+    auto literal = this->lst_regex.required_literal();
+    if (literal.size() > 1) {
+        this->lst_literal = std::move(literal);
+        this->lst_literal_caseless
+            = this->lst_regex.get_options() & PCRE_CASELESS;
+    }
+}
+
+static bool
+contains_literal(const shared_buffer_ref& sbr,
+                 const std::string& literal,
+                 bool caseless)
+{
+    const auto* data = sbr.get_data();
+    const auto len = sbr.length();
+
+    if (!caseless) {
+        return memmem(data, len, literal.data(), literal.size()) != nullptr;
+    }
+
+    if (len < literal.size()) {
+        return false;
+    }
+
+    const auto first = tolower((unsigned char) literal[0]);
+    for (size_t lpc = 0; lpc <= len - literal.size(); lpc++) {
+        if (tolower((unsigned char) data[lpc]) == first
+            && strncasecmp(&data[lpc + 1], &literal[1], literal.size() - 1)
+                == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
 }
 
 void
@@ -118,12 +156,15 @@ log_search_table::next(log_cursor& lc, logfile_sub_source& lss)
         return false;
     }
 
-    string_attrs_t sa;
-    std::vector<logline_value> line_values;
-
     lf->read_full_message(lf_iter, this->lst_current_line);
-    lf->get_format()->annotate(
-        cl, this->lst_current_line, sa, line_values, false);
+    if (!this->lst_literal.empty()
+        && !contains_literal(this->lst_current_line,
+                             this->lst_literal,
+                             this->lst_literal_caseless))
+    {
+        return false;
+    }
+
     pcre_input pi(
         this->lst_current_line.get_data(), 0, this->lst_current_line.length());
 
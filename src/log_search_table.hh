@@ -65,6 +65,9 @@ public:
                  std::vector<logline_value>& values) override;
 
     pcrepp lst_regex;
+    /** Text that has to be in a message for the regex to match. */
+    std::string lst_literal;
+    bool lst_literal_caseless{false};
     shared_buffer_ref lst_current_line;
     pcre_context_static<128> lst_match_context;
     std::vector<logline_value_meta> lst_column_metas;
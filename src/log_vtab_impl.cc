@@ -27,9 +27,13 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <future>
+#include <thread>
+
 #include "log_vtab_impl.hh"
 
 #include "base/lnav_log.hh"
+#include "base/perf_stats.hh"
 #include "base/string_util.hh"
 #include "config.h"
 #include "logfile_sub_source.hh"
@@ -173,13 +177,162 @@ struct vtab {
     std::shared_ptr<log_vtab_impl> vi;
 };
 
+struct prefetched_row {
+    vis_line_t pr_line;
+    std::shared_ptr<log_format> pr_format;
+    uint64_t pr_line_number{0};
+    shared_buffer_ref pr_msg;
+    string_attrs_t pr_attrs;
+    std::vector<logline_value> pr_values;
+    bool pr_consumed{false};
+};
+
 struct vtab_cursor {
     sqlite3_vtab_cursor base;
     struct log_cursor log_cursor;
     shared_buffer_ref log_msg;
     std::vector<logline_value> line_values;
+    std::vector<prefetched_row> prefetched;
+    size_t prefetch_index{0};
+    size_t prefetch_size{0};
 };
 
+/**
+ * Read the messages for the rows ahead of the cursor and extract their
+ * values on worker threads.  The batch size starts small so that queries
+ * with a LIMIT do not pay for rows they never look at.
+ */
+static void
+vt_prefetch(vtab* vt, vtab_cursor* vc)
+{
+    static const size_t MIN_BATCH_SIZE = 64;
+    static const size_t MAX_BATCH_SIZE = 16 * 1024;
+    static const size_t MIN_ROWS_PER_WORKER = 256;
+
+    auto& lss = *vt->lss;
+
+    vc->prefetched.clear();
+    vc->prefetch_index = 0;
+    vc->prefetch_size = vc->prefetch_size == 0
+        ? MIN_BATCH_SIZE
+        : std::min(vc->prefetch_size * 2, MAX_BATCH_SIZE);
+
+    for (auto vl = vc->log_cursor.lc_curr_line;
+         vl < vc->log_cursor.lc_end_line
+         && vc->prefetched.size() < vc->prefetch_size;
+         ++vl)
+    {
+        uint64_t line_number;
+        auto ld = lss.find_data(lss.at(vl), line_number);
+        auto* lf = (*ld)->get_file_ptr();
+        auto ll = lf->begin() + line_number;
+        auto pf = vt->vi->can_prefetch(*lf, *ll);
+
+        if (pf == log_vtab_impl::prefetch_t::SKIP) {
+            continue;
+        }
+        if (pf == log_vtab_impl::prefetch_t::STOP) {
+            break;
+        }
+
+        vc->prefetched.emplace_back();
+
+        auto& pr = vc->prefetched.back();
+
+        pr.pr_line = vl;
+        pr.pr_format = lf->get_format();
+        pr.pr_line_number = line_number;
+        lf->read_full_message(ll, pr.pr_msg);
+        // The workers must not touch the line buffer's list of references.
+        pr.pr_msg.take_ownership();
+    }
+
+    auto extract_range = [vc](size_t start, size_t end) {
+        for (size_t lpc = start; lpc < end; lpc++) {
+            auto& pr = vc->prefetched[lpc];
+
+            pr.pr_format->annotate(pr.pr_line_number,
+                                   pr.pr_msg,
+                                   pr.pr_attrs,
+                                   pr.pr_values,
+                                   false);
+        }
+    };
+
+    size_t worker_count = std::min(
+        (size_t) std::max(1U, std::thread::hardware_concurrency()),
+        vc->prefetched.size() / MIN_ROWS_PER_WORKER);
+
+    if (worker_count <= 1) {
+        extract_range(0, vc->prefetched.size());
+        return;
+    }
+
+    std::vector<std::future<void>> workers;
+    size_t rows_per_worker
+        = (vc->prefetched.size() + worker_count - 1) / worker_count;
+
+    for (size_t start = 0; start < vc->prefetched.size();
+         start += rows_per_worker)
+    {
+        auto end = std::min(start + rows_per_worker, vc->prefetched.size());
+
+        workers.emplace_back(
+            std::async(std::launch::async, extract_range, start, end));
+    }
+    for (auto& worker : workers) {
+        worker.get();
+    }
+}
+
+/**
+ * Make sure the values for the cursor's current row have been extracted.
+ */
+static void
+vt_extract(vtab* vt,
+           vtab_cursor* vc,
+           const std::shared_ptr<logfile>& lf,
+           uint64_t line_number,
+           logfile::iterator ll)
+{
+    if (!vc->line_values.empty()) {
+        return;
+    }
+
+    auto curr_line = vc->log_cursor.lc_curr_line;
+
+    while (vc->prefetch_index < vc->prefetched.size()
+           && vc->prefetched[vc->prefetch_index].pr_line < curr_line)
+    {
+        vc->prefetch_index += 1;
+    }
+    if ((vc->prefetch_index == vc->prefetched.size()
+         || vc->prefetched[vc->prefetch_index].pr_line != curr_line)
+        && vt->vi->can_prefetch(*lf, *ll)
+            == log_vtab_impl::prefetch_t::EXTRACT)
+    {
+        vt_prefetch(vt, vc);
+    }
+    if (vc->prefetch_index < vc->prefetched.size()
+        && vc->prefetched[vc->prefetch_index].pr_line == curr_line)
+    {
+        auto& pr = vc->prefetched[vc->prefetch_index];
+
+        if (pr.pr_consumed) {
+            // The row did not have any values, the attributes are still set.
+            return;
+        }
+        pr.pr_consumed = true;
+        vc->log_msg = pr.pr_msg;
+        vc->line_values = std::move(pr.pr_values);
+        vt->vi->vi_attrs = std::move(pr.pr_attrs);
+        return;
+    }
+
+    lf->read_full_message(ll, vc->log_msg);
+    vt->vi->extract(lf, line_number, vc->log_msg, vc->line_values);
+}
+
 static int vt_destructor(sqlite3_vtab* p_svt);
 
 static int
@@ -303,9 +456,14 @@ vt_next(sqlite3_vtab_cursor* cur)
             && (log_vtab_data.lvd_progress != NULL
                 && log_vtab_data.lvd_progress(log_cursor_latest)))
         {
+            // The current line was rejected by next(), so move to the end
+            // to keep the columns from being read before the interrupt is
+            // seen.
+            vc->log_cursor.lc_curr_line = vc->log_cursor.lc_end_line;
             break;
         }
         done = vt->vi->next(vc->log_cursor, *vt->lss);
+        lnav::perf::add(lnav::perf::counter_t::SQL_ROWS_SCANNED);
     } while (!done);
 
     return SQLITE_OK;
@@ -377,11 +535,7 @@ vt_column(sqlite3_vtab_cursor* cur, sqlite3_context* ctx, int col)
             char buffer[64];
 
             if (ll->is_time_skewed()) {
-                if (vc->line_values.empty()) {
-                    lf->read_full_message(ll, vc->log_msg);
-                    vt->vi->extract(
-                        lf, line_number, vc->log_msg, vc->line_values);
-                }
+                vt_extract(vt, vc, lf, line_number, ll);
 
                 struct line_range time_range;
 
@@ -549,11 +703,7 @@ vt_column(sqlite3_vtab_cursor* cur, sqlite3_context* ctx, int col)
                         break;
                     }
                     case 3: {
-                        if (vc->line_values.empty()) {
-                            lf->read_full_message(ll, vc->log_msg);
-                            vt->vi->extract(
-                                lf, line_number, vc->log_msg, vc->line_values);
-                        }
+                        vt_extract(vt, vc, lf, line_number, ll);
 
                         struct line_range body_range;
 
@@ -592,11 +742,7 @@ vt_column(sqlite3_vtab_cursor* cur, sqlite3_context* ctx, int col)
                     }
                 }
             } else {
-                if (vc->line_values.empty()) {
-                    lf->read_full_message(ll, vc->log_msg);
-                    vt->vi->extract(
-                        lf, line_number, vc->log_msg, vc->line_values);
-                }
+                vt_extract(vt, vc, lf, line_number, ll);
 
                 size_t sub_col = col - VT_COL_MAX;
                 std::vector<logline_value>::iterator lv_iter;
@@ -829,6 +975,9 @@ vt_filter(sqlite3_vtab_cursor* p_vtc,
         = (sqlite3_index_info::sqlite3_index_constraint*) idxStr;
 
     log_info("(%p) filter called: %d", vt, idxNum);
+    p_cur->prefetched.clear();
+    p_cur->prefetch_index = 0;
+    p_cur->prefetch_size = 0;
     p_cur->log_cursor.lc_curr_line = -1_vl;
     p_cur->log_cursor.lc_end_line = vis_line_t(vt->lss->text_line_count());
     vt_next(p_vtc);
@@ -34,6 +34,7 @@
 #include <string>
 #include <vector>
 
+#include <signal.h>
 #include <sqlite3.h>
 
 #include "logfile_sub_source.hh"
@@ -135,6 +136,23 @@ public:
 
     virtual bool next(log_cursor& lc, logfile_sub_source& lss) = 0;
 
+    enum class prefetch_t {
+        SKIP, /*< The line is not a row in this table. */
+        EXTRACT, /*< The line is a row and can be extracted on any thread. */
+        STOP, /*< The line has to go through next() and extract(). */
+    };
+
+    /**
+     * Check whether the values for a line can be extracted ahead of the
+     * cursor on a worker thread.  Returning EXTRACT promises that the line
+     * is a row in this table and that extract() for it is the same as
+     * calling the file format's annotate() without touching this object.
+     */
+    virtual prefetch_t can_prefetch(const logfile& lf, const logline& ll) const
+    {
+        return prefetch_t::STOP;
+    }
+
     virtual void get_columns(std::vector<vtab_column>& cols) const {};
 
     virtual void get_foreign_keys(std::vector<std::string>& keys_inout) const
@@ -212,6 +230,13 @@ extern struct _log_vtab_data {
     sql_progress_finished_callback_t lvd_finished;
     std::string lvd_source;
     int lvd_line_number{0};
+    /** True while a statement is executing under a sql_progress_guard. */
+    sig_atomic_t lvd_running{0};
+    /** Set from the SIGINT handler to cancel the running statement. */
+    sig_atomic_t lvd_interrupted{0};
+    /** The number of distinct log lines visited by the running statement. */
+    int64_t lvd_rows_scanned{0};
+    int64_t lvd_last_line{-1};
 } log_vtab_data;
 
 class sql_progress_guard {
@@ -225,6 +250,10 @@ public:
         log_vtab_data.lvd_finished = fcb;
         log_vtab_data.lvd_source = source;
         log_vtab_data.lvd_line_number = line_number;
+        log_vtab_data.lvd_interrupted = false;
+        log_vtab_data.lvd_rows_scanned = 0;
+        log_vtab_data.lvd_last_line = -1;
+        log_vtab_data.lvd_running = true;
     };
 
     ~sql_progress_guard()
@@ -232,6 +261,8 @@ public:
         if (log_vtab_data.lvd_finished) {
             log_vtab_data.lvd_finished();
         }
+        log_vtab_data.lvd_running = false;
+        log_vtab_data.lvd_interrupted = false;
         log_vtab_data.lvd_progress = nullptr;
         log_vtab_data.lvd_finished = nullptr;
         log_vtab_data.lvd_source.clear();
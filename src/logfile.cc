@@ -44,6 +44,7 @@
 
 #include "base/fs_util.hh"
 #include "base/injector.hh"
+#include "base/perf_stats.hh"
 #include "base/string_util.hh"
 #include "config.h"
 #include "lnav_util.hh"
@@ -217,6 +218,7 @@ logfile::process_prefix(shared_buffer_ref& sbr, const line_info& li)
 
             (*iter)->clear();
             this->set_format_base_time(iter->get());
+            lnav::perf::add(lnav::perf::counter_t::FORMAT_DETECTIONS);
             found = (*iter)->scan(*this, this->lf_index, li, sbr);
             if (found == log_format::SCAN_MATCH) {
 #if 0
@@ -250,6 +252,7 @@ logfile::process_prefix(shared_buffer_ref& sbr, const line_info& li)
                         this->lf_index[lpc].set_ignore(true);
                     }
                 }
+                this->invalidate_block_summaries();
                 break;
             }
         }
@@ -337,6 +340,7 @@ logfile::rebuild_index(nonstd::optional<ui_clock::time_point> deadline)
         return rebuild_result_t::NO_NEW_LINES;
     }
 
+    lnav::perf::timer rebuild_timer(lnav::perf::counter_t::INDEX_REBUILDS);
     auto retval = rebuild_result_t::NO_NEW_LINES;
     struct stat st;
 
@@ -405,6 +409,10 @@ logfile::rebuild_index(nonstd::optional<ui_clock::time_point> deadline)
             this->lf_index.pop_back();
             rollback_size += 1;
 
+            // The dropped lines might be indexed differently this time.
+            this->lf_message_length_cache.clear();
+            this->lf_message_cache.clear();
+            this->invalidate_block_summaries(this->lf_index.size());
             this->lf_line_buffer.clear();
             if (!this->lf_index.empty()) {
                 auto last_line = this->lf_index.end();
@@ -600,7 +608,14 @@ logfile::rebuild_index(nonstd::optional<ui_clock::time_point> deadline)
         this->lf_index_size = prev_range.next_offset();
         this->lf_stat = st;
 
+        if (this->lf_index.size() > begin_size) {
+            lnav::perf::add(lnav::perf::counter_t::LINES_INDEXED,
+                            this->lf_index.size() - begin_size);
+        }
+
         if (sort_needed) {
+            // Earlier lines might have had their times adjusted.
+            this->invalidate_block_summaries();
             retval = rebuild_result_t::NEW_ORDER;
         } else {
             retval = rebuild_result_t::NEW_LINES;
@@ -652,16 +667,38 @@ logfile::read_full_message(logfile::const_iterator ll,
                            shared_buffer_ref& msg_out,
                            int max_lines)
 {
+    static const size_t MAX_CACHED_MESSAGE_SIZE = 256 * 1024;
+
     require(ll->get_sub_offset() == 0);
 
     try {
-        auto read_result
-            = this->lf_line_buffer.read_range(this->get_file_range(ll));
+        auto cached = this->lf_message_cache.get(ll->get_offset());
+
+        if (cached) {
+            auto& cm = *cached.value();
+
+            msg_out.share(cm.cm_buffer, cm.cm_data.data(), cm.cm_data.size());
+        } else {
+            auto range = this->get_file_range(ll);
+            auto read_result = this->lf_line_buffer.read_range(range);
+
+            if (read_result.isErr()) {
+                return;
+            }
+            msg_out = read_result.unwrap();
 
-        if (read_result.isErr()) {
-            return;
+            auto next_line = ll + 1;
+            if (next_line != this->end() && next_line->is_continued()
+                && this->lf_message_length_cache.exists(ll->get_offset())
+                && msg_out.length() <= MAX_CACHED_MESSAGE_SIZE)
+            {
+                auto cm = std::make_shared<cached_message>();
+
+                cm->cm_data.assign(msg_out.get_data(),
+                                   msg_out.get_data() + msg_out.length());
+                this->lf_message_cache.put(ll->get_offset(), cm);
+            }
         }
-        msg_out = read_result.unwrap();
         if (this->lf_format.get() != nullptr) {
             this->lf_format->get_subline(*ll, msg_out, true);
         }
@@ -670,6 +707,59 @@ logfile::read_full_message(logfile::const_iterator ll,
     }
 }
 
+void
+logfile::update_block_summaries()
+{
+    if (this->lf_summarized_lines >= this->lf_index.size()) {
+        return;
+    }
+
+    // Only complete blocks are summarized since the last block is still
+    // growing and would need to be redone anyway.
+    auto start_block = this->lf_summarized_lines / SUMMARY_BLOCK_SIZE;
+    auto end_block = this->lf_index.size() / SUMMARY_BLOCK_SIZE;
+
+    this->lf_block_summaries.resize(end_block);
+    for (auto block = start_block; block < end_block; block++) {
+        auto& bs = this->lf_block_summaries[block];
+        auto iter = this->lf_index.begin() + block * SUMMARY_BLOCK_SIZE;
+        auto end = iter + SUMMARY_BLOCK_SIZE;
+        bool first = true;
+
+        bs = block_summary{};
+        for (; iter != end; ++iter) {
+            auto tv = iter->get_timeval();
+
+            if (first || tv < bs.bs_min_time) {
+                bs.bs_min_time = tv;
+            }
+            if (first || bs.bs_max_time < tv) {
+                bs.bs_max_time = tv;
+            }
+            bs.bs_level_mask |= 1U << iter->get_msg_level();
+            first = false;
+        }
+    }
+    this->lf_summarized_lines = end_block * SUMMARY_BLOCK_SIZE;
+}
+
+void
+logfile::find_excluded_blocks(log_level_t min_level,
+                              const struct timeval& min_time,
+                              const struct timeval& max_time,
+                              std::vector<bool>& excluded_out)
+{
+    this->update_block_summaries();
+
+    excluded_out.resize(this->lf_block_summaries.size());
+    for (size_t block = 0; block < this->lf_block_summaries.size(); block++) {
+        const auto& bs = this->lf_block_summaries[block];
+
+        excluded_out[block] = (bs.bs_level_mask >> min_level) == 0
+            || bs.bs_max_time < min_time || max_time < bs.bs_min_time;
+    }
+}
+
 void
 logfile::set_logline_observer(logline_observer* llo)
 {
@@ -732,6 +822,15 @@ logfile::line_length(logfile::const_iterator ll, bool include_continues)
         }
     }
 
+    if (include_continues) {
+        auto cached_length
+            = this->lf_message_length_cache.get(ll->get_offset());
+
+        if (cached_length) {
+            return cached_length.value();
+        }
+    }
+
     do {
         ++next_line;
     } while ((next_line != this->end())
@@ -751,6 +850,10 @@ logfile::line_length(logfile::const_iterator ll, bool include_continues)
         if (!include_continues) {
             this->lf_next_line_cache = nonstd::make_optional(
                 std::make_pair(ll->get_offset(), retval));
+        } else if (std::distance(ll, next_line) > 1) {
+            // Only multi-line messages are worth remembering, finding the
+            // end of a single line is cheap.
+            this->lf_message_length_cache.put(ll->get_offset(), retval);
         }
     }
 
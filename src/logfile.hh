@@ -44,6 +44,7 @@
 #include <sys/types.h>
 
 #include "base/lnav_log.hh"
+#include "base/lrucache.hpp"
 #include "base/result.h"
 #include "byte_array.hh"
 #include "ghc/filesystem.hpp"
@@ -236,6 +237,7 @@ public:
             iter.set_time(new_time);
         }
         this->lf_sort_needed = true;
+        this->invalidate_block_summaries();
     };
 
     void clear_time_offset()
@@ -399,6 +401,39 @@ public:
 
     void reobserve_from(iterator iter);
 
+    /**
+     * Summary of the lines in a block of SUMMARY_BLOCK_SIZE lines, used to
+     * quickly rule out blocks that cannot pass a level or time filter.
+     */
+    struct block_summary {
+        struct timeval bs_min_time {
+            0, 0
+        };
+        struct timeval bs_max_time {
+            0, 0
+        };
+        /** A bit for each log_level_t of the lines in the block. */
+        uint32_t bs_level_mask{0};
+    };
+
+    static constexpr size_t SUMMARY_BLOCK_SIZE = 1024;
+
+    /**
+     * Find the blocks of SUMMARY_BLOCK_SIZE lines that cannot contain any
+     * lines that pass the given filters.  The last block is still growing,
+     * so it is never reported as excluded.
+     *
+     * @param min_level The minimum log level.
+     * @param min_time The lower bound for the line times.
+     * @param max_time The upper bound for the line times.
+     * @param excluded_out Set to a flag for each block that is true when
+     *   no line in the block can pass the filters.
+     */
+    void find_excluded_blocks(log_level_t min_level,
+                              const struct timeval& min_time,
+                              const struct timeval& max_time,
+                              std::vector<bool>& excluded_out);
+
     void set_logfile_observer(logfile_observer* lo)
     {
         this->lf_logfile_observer = lo;
@@ -467,6 +502,14 @@ protected:
 
     void set_format_base_time(log_format* lf);
 
+    void invalidate_block_summaries(size_t from_line = 0)
+    {
+        this->lf_summarized_lines
+            = std::min(this->lf_summarized_lines, from_line);
+    }
+
+    void update_block_summaries();
+
 private:
     logfile(std::string filename, logfile_open_options& loo);
 
@@ -501,6 +544,30 @@ private:
     safe_notes lf_notes;
 
     nonstd::optional<std::pair<file_off_t, size_t>> lf_next_line_cache;
+
+    /**
+     * The contents of a recently read multi-line message.  Messages handed
+     * out from the cache share this buffer until the entry is evicted.
+     * The data is declared first so that it outlives the buffer, which
+     * copies it into any outstanding references when it is destroyed.
+     */
+    struct cached_message {
+        std::vector<char> cm_data;
+        shared_buffer cm_buffer;
+    };
+
+    /**
+     * The lengths of recently read multi-line messages, keyed by the offset
+     * of the first line.  Only messages that are followed by another one are
+     * stored since the last message in the file can still grow.
+     */
+    cache::lru_cache<file_off_t, size_t> lf_message_length_cache{1024};
+    cache::lru_cache<file_off_t, std::shared_ptr<cached_message>>
+        lf_message_cache{16};
+
+    std::vector<block_summary> lf_block_summaries;
+    /** The number of lines covered by lf_block_summaries. */
+    size_t lf_summarized_lines{0};
 };
 
 class logline_observer {
@@ -29,6 +29,7 @@
 
 #include <algorithm>
 #include <future>
+#include <thread>
 
 #include "logfile_sub_source.hh"
 
@@ -36,6 +37,7 @@
 
 #include "ansi_scrubber.hh"
 #include "base/humanize.time.hh"
+#include "base/sort_util.hh"
 #include "base/string_util.hh"
 #include "command_executor.hh"
 #include "config.h"
@@ -176,111 +178,150 @@ logfile_sub_source::text_value_for_line(textview_curses& tc,
     this->lss_token_file = (*this->lss_token_file_data)->get_file();
     this->lss_token_line = this->lss_token_file->begin() + line;
 
-    this->lss_token_attrs.clear();
-    this->lss_token_values.clear();
     this->lss_share_manager.invalidate_refs();
-    if (flags & text_sub_source::RF_FULL) {
-        shared_buffer_ref sbr;
 
-        this->lss_token_file->read_full_message(this->lss_token_line, sbr);
-        this->lss_token_value = to_string(sbr);
-    } else {
-        this->lss_token_value
-            = this->lss_token_file->read_line(this->lss_token_line)
-                  .map([](auto sbr) { return to_string(sbr); })
-                  .unwrapOr({});
-    }
-    this->lss_token_shift_start = 0;
-    this->lss_token_shift_size = 0;
+    // Lines that are rewritten can run arbitrary scripts, so they are never
+    // cached.
+    auto cache_key = render_cache_key{line, flags & RF_FULL};
+    nonstd::optional<rendered_line> cached_line;
 
-    auto format = this->lss_token_file->get_format();
-
-    value_out = this->lss_token_value;
-    if (this->lss_flags & F_SCRUB) {
-        format->scrub(value_out);
+    if (!(flags & RF_REWRITE)) {
+        cached_line = this->lss_render_cache.get(cache_key);
     }
 
-    shared_buffer_ref sbr;
+    if (cached_line) {
+        auto& rl = cached_line.value();
 
-    sbr.share(this->lss_share_manager,
-              (char*) this->lss_token_value.c_str(),
-              this->lss_token_value.size());
-    if (this->lss_token_line->is_continued()) {
-        this->lss_token_attrs.emplace_back(
-            line_range{0, (int) this->lss_token_value.length()},
-            SA_BODY.value());
+        this->lss_token_value = std::move(rl.rl_token_value);
+        this->lss_token_attrs = std::move(rl.rl_attrs);
+        this->lss_token_values = std::move(rl.rl_values);
+        this->lss_token_shift_start = rl.rl_shift_start;
+        this->lss_token_shift_size = rl.rl_shift_size;
+        value_out = std::move(rl.rl_value);
     } else {
-        format->annotate(
-            line, sbr, this->lss_token_attrs, this->lss_token_values);
-    }
-    if (this->lss_token_line->get_sub_offset() != 0) {
         this->lss_token_attrs.clear();
-    }
-    if (flags & RF_REWRITE) {
-        exec_context ec(
-            &this->lss_token_values, pretty_sql_callback, pretty_pipe_callback);
-        std::string rewritten_line;
-
-        ec.with_perms(exec_context::perm_t::READ_ONLY);
-        ec.ec_local_vars.push(std::map<std::string, std::string>());
-        ec.ec_top_line = vis_line_t(row);
-        add_ansi_vars(ec.ec_global_vars);
-        add_global_vars(ec);
-        format->rewrite(ec, sbr, this->lss_token_attrs, rewritten_line);
-        this->lss_token_value.assign(rewritten_line);
+        this->lss_token_values.clear();
+        if (flags & text_sub_source::RF_FULL) {
+            shared_buffer_ref sbr;
+
+            this->lss_token_file->read_full_message(this->lss_token_line, sbr);
+            this->lss_token_value = to_string(sbr);
+        } else {
+            this->lss_token_value
+                = this->lss_token_file->read_line(this->lss_token_line)
+                      .map([](auto sbr) { return to_string(sbr); })
+                      .unwrapOr({});
+        }
+        this->lss_token_shift_start = 0;
+        this->lss_token_shift_size = 0;
+
+        auto format = this->lss_token_file->get_format();
+
         value_out = this->lss_token_value;
-    }
+        if (this->lss_flags & F_SCRUB) {
+            format->scrub(value_out);
+        }
 
-    if ((this->lss_token_file->is_time_adjusted()
-         || format->lf_timestamp_flags & ETF_MACHINE_ORIENTED
-         || !(format->lf_timestamp_flags & ETF_DAY_SET)
-         || !(format->lf_timestamp_flags & ETF_MONTH_SET))
-        && format->lf_date_time.dts_fmt_lock != -1)
-    {
-        auto time_attr
-            = find_string_attr(this->lss_token_attrs, &logline::L_TIMESTAMP);
-        if (time_attr != this->lss_token_attrs.end()) {
-            const struct line_range time_range = time_attr->sa_range;
-            struct timeval adjusted_time;
-            struct exttm adjusted_tm;
-            char buffer[128];
-            const char* fmt;
-            ssize_t len;
-
-            if (format->lf_timestamp_flags & ETF_MACHINE_ORIENTED
-                || !(format->lf_timestamp_flags & ETF_DAY_SET)
-                || !(format->lf_timestamp_flags & ETF_MONTH_SET))
-            {
-                format->lf_date_time.convert_to_timeval(
-                    &this->lss_token_value.c_str()[time_range.lr_start],
-                    time_range.length(),
-                    format->get_timestamp_formats(),
-                    adjusted_time);
-                fmt = "%Y-%m-%d %H:%M:%S.%f";
-                gmtime_r(&adjusted_time.tv_sec, &adjusted_tm.et_tm);
-                adjusted_tm.et_nsec
-                    = std::chrono::duration_cast<std::chrono::nanoseconds>(
-                          std::chrono::microseconds{adjusted_time.tv_usec})
-                          .count();
-                len = ftime_fmt(buffer, sizeof(buffer), fmt, adjusted_tm);
-            } else {
-                adjusted_time = this->lss_token_line->get_timeval();
-                gmtime_r(&adjusted_time.tv_sec, &adjusted_tm.et_tm);
-                adjusted_tm.et_nsec
-                    = std::chrono::duration_cast<std::chrono::nanoseconds>(
-                          std::chrono::microseconds{adjusted_time.tv_usec})
-                          .count();
-                len = format->lf_date_time.ftime(
-                    buffer,
-                    sizeof(buffer),
-                    format->get_timestamp_formats(),
-                    adjusted_tm);
+        shared_buffer_ref sbr;
+
+        sbr.share(this->lss_share_manager,
+                  (char*) this->lss_token_value.c_str(),
+                  this->lss_token_value.size());
+        if (this->lss_token_line->is_continued()) {
+            this->lss_token_attrs.emplace_back(
+                line_range{0, (int) this->lss_token_value.length()},
+                SA_BODY.value());
+        } else {
+            format->annotate(
+                line, sbr, this->lss_token_attrs, this->lss_token_values);
+        }
+        if (this->lss_token_line->get_sub_offset() != 0) {
+            this->lss_token_attrs.clear();
+        }
+        if (flags & RF_REWRITE) {
+            exec_context ec(&this->lss_token_values,
+                            pretty_sql_callback,
+                            pretty_pipe_callback);
+            std::string rewritten_line;
+
+            ec.with_perms(exec_context::perm_t::READ_ONLY);
+            ec.ec_local_vars.push(std::map<std::string, std::string>());
+            ec.ec_top_line = vis_line_t(row);
+            add_ansi_vars(ec.ec_global_vars);
+            add_global_vars(ec);
+            format->rewrite(ec, sbr, this->lss_token_attrs, rewritten_line);
+            this->lss_token_value.assign(rewritten_line);
+            value_out = this->lss_token_value;
+        }
+
+        if ((this->lss_token_file->is_time_adjusted()
+             || format->lf_timestamp_flags & ETF_MACHINE_ORIENTED
+             || !(format->lf_timestamp_flags & ETF_DAY_SET)
+             || !(format->lf_timestamp_flags & ETF_MONTH_SET))
+            && format->lf_date_time.dts_fmt_lock != -1)
+        {
+            auto time_attr = find_string_attr(this->lss_token_attrs,
+                                              &logline::L_TIMESTAMP);
+            if (time_attr != this->lss_token_attrs.end()) {
+                const struct line_range time_range = time_attr->sa_range;
+                struct timeval adjusted_time;
+                struct exttm adjusted_tm;
+                char buffer[128];
+                const char* fmt;
+                ssize_t len;
+
+                if (format->lf_timestamp_flags & ETF_MACHINE_ORIENTED
+                    || !(format->lf_timestamp_flags & ETF_DAY_SET)
+                    || !(format->lf_timestamp_flags & ETF_MONTH_SET))
+                {
+                    format->lf_date_time.convert_to_timeval(
+                        &this->lss_token_value.c_str()[time_range.lr_start],
+                        time_range.length(),
+                        format->get_timestamp_formats(),
+                        adjusted_time);
+                    fmt = "%Y-%m-%d %H:%M:%S.%f";
+                    gmtime_r(&adjusted_time.tv_sec, &adjusted_tm.et_tm);
+                    adjusted_tm.et_nsec
+                        = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::microseconds{
+                                  adjusted_time.tv_usec})
+                              .count();
+                    len = ftime_fmt(buffer, sizeof(buffer), fmt, adjusted_tm);
+                } else {
+                    adjusted_time = this->lss_token_line->get_timeval();
+                    gmtime_r(&adjusted_time.tv_sec, &adjusted_tm.et_tm);
+                    adjusted_tm.et_nsec
+                        = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::microseconds{
+                                  adjusted_time.tv_usec})
+                              .count();
+                    len = format->lf_date_time.ftime(
+                        buffer,
+                        sizeof(buffer),
+                        format->get_timestamp_formats(),
+                        adjusted_tm);
+                }
+
+                value_out.replace(
+                    time_range.lr_start, time_range.length(), buffer, len);
+                this->lss_token_shift_start = time_range.lr_start;
+                this->lss_token_shift_size = len - time_range.length();
             }
+        }
 
-            value_out.replace(
-                time_range.lr_start, time_range.length(), buffer, len);
-            this->lss_token_shift_start = time_range.lr_start;
-            this->lss_token_shift_size = len - time_range.length();
+        if (!(flags & RF_REWRITE)) {
+            rendered_line rl;
+
+            // Make sure the values own their data before they are copied
+            // into the cache.
+            this->lss_share_manager.invalidate_refs();
+            rl.rl_token_value = this->lss_token_value;
+            rl.rl_value = value_out;
+            rl.rl_attrs = this->lss_token_attrs;
+            rl.rl_values = this->lss_token_values;
+            rl.rl_shift_start = this->lss_token_shift_start;
+            rl.rl_shift_size = this->lss_token_shift_size;
+            this->lss_render_cache.put(cache_key, rl);
         }
     }
 
@@ -615,18 +656,45 @@ logfile_sub_source::text_attrs_for_line(textview_curses& lv,
     }
 }
 
+/**
+ * Sort the given line numbers of a file by time.  Large files are split into
+ * chunks that are sorted on separate threads and then merged.
+ */
+static void
+sort_file_lines(logfile& lf, std::vector<uint32_t>& lines)
+{
+    static const size_t PARALLEL_SORT_THRESHOLD = 256 * 1024;
+
+    auto line_cmp = [&lf](uint32_t lhs, uint32_t rhs) {
+        return lf[lhs] < lf[rhs];
+    };
+
+    if (std::is_sorted(lines.begin(), lines.end(), line_cmp)) {
+        return;
+    }
+
+    size_t chunk_count = std::min<size_t>(
+        std::max(1U, std::thread::hardware_concurrency()),
+        lines.size() / PARALLEL_SORT_THRESHOLD);
+    lnav::sorting::parallel_stable_sort(
+        lines.begin(), lines.end(), line_cmp, chunk_count);
+}
+
 logfile_sub_source::rebuild_result
 logfile_sub_source::rebuild_index(
     nonstd::optional<ui_clock::time_point> deadline)
 {
     iterator iter;
     size_t total_lines = 0;
-    bool full_sort = false;
     int file_count = 0;
     bool force = this->lss_force_rebuild;
     auto retval = rebuild_result::rr_no_change;
     nonstd::optional<struct timeval> lowest_tv = nonstd::nullopt;
     vis_line_t search_start = 0_vl;
+    // The files whose lines need to be sorted and spliced into the index
+    // instead of being merged in file order.
+    std::vector<bool> reordered(this->lss_files.size(), false);
+    bool any_reordered = false;
 
     this->lss_force_rebuild = false;
     if (force) {
@@ -686,6 +754,7 @@ logfile_sub_source::rebuild_index(
                         if (retval == rebuild_result::rr_no_change) {
                             retval = rebuild_result::rr_appended_lines;
                         }
+                        this->invalidate_last_message(ld);
                         log_debug("new lines for %s:%d",
                                   lf->get_filename().c_str(),
                                   lf->size());
@@ -726,12 +795,19 @@ logfile_sub_source::rebuild_index(
                         }
                         break;
                     case logfile::rebuild_result_t::INVALID:
-                    case logfile::rebuild_result_t::NEW_ORDER:
-                        log_debug("%s: log file has a new order, full rebuild",
+                        log_debug("%s: log file is invalid, full rebuild",
                                   lf->get_filename().c_str());
                         retval = rebuild_result::rr_full_rebuild;
                         force = true;
-                        full_sort = true;
+                        break;
+                    case logfile::rebuild_result_t::NEW_ORDER:
+                        log_debug("%s: log file has a new order, splicing",
+                                  lf->get_filename().c_str());
+                        if (retval <= rebuild_result::rr_partial_rebuild) {
+                            retval = rebuild_result::rr_partial_rebuild;
+                        }
+                        reordered[file_index] = true;
+                        any_reordered = true;
                         break;
                 }
             }
@@ -750,11 +826,23 @@ logfile_sub_source::rebuild_index(
     }
 
     auto& vis_bm = this->tss_view->get_bookmarks();
+    // The first row in the index that is affected by the rebuild.
+    size_t splice_start = this->lss_index.size();
 
     if (force) {
         for (iter = this->lss_files.begin(); iter != this->lss_files.end();
              iter++) {
+            auto lf = (*iter)->get_file_ptr();
+
             (*iter)->ld_lines_indexed = 0;
+            // Files that are not in time order cannot go through the merge
+            // and are sorted separately.
+            if (lf != nullptr && !reordered[(*iter)->ld_file_index]
+                && !std::is_sorted(lf->begin(), lf->end()))
+            {
+                reordered[(*iter)->ld_file_index] = true;
+                any_reordered = true;
+            }
         }
 
         this->lss_index.clear();
@@ -763,7 +851,36 @@ logfile_sub_source::rebuild_index(
         this->lss_basename_width = 0;
         this->lss_filename_width = 0;
         vis_bm[&textview_curses::BM_USER_EXPR].clear();
-    } else if (retval == rebuild_result::rr_partial_rebuild) {
+    } else if (any_reordered) {
+        // Drop the rows for the reordered files, the remaining rows are still
+        // in order and the reordered files are spliced back in below.
+        auto is_reordered = [&reordered](const indexed_content& ic) {
+            return reordered[content_line_t(ic) / MAX_LINES_PER_FILE];
+        };
+        auto first_removed = std::find_if(
+            this->lss_index.begin(), this->lss_index.end(), is_reordered);
+        auto new_end = std::remove_if(
+            first_removed, this->lss_index.end(), is_reordered);
+
+        splice_start = std::distance(this->lss_index.begin(), first_removed);
+        this->lss_index.shrink_to(
+            std::distance(this->lss_index.begin(), new_end));
+        log_debug("removed reordered rows starting at %ld; new size %ld",
+                  splice_start,
+                  this->lss_index.size());
+    }
+
+    if (any_reordered) {
+        for (auto& ld : this->lss_files) {
+            auto lf = ld->get_file_ptr();
+
+            if (lf != nullptr && reordered[ld->ld_file_index]) {
+                ld->ld_lines_indexed = lf->size();
+            }
+        }
+    }
+
+    if (!force && lowest_tv) {
         size_t remaining = 0;
 
         log_debug("partial rebuild with lowest time: %ld",
@@ -773,7 +890,7 @@ logfile_sub_source::rebuild_index(
             logfile_data& ld = *(*iter);
             auto lf = ld.get_file_ptr();
 
-            if (lf == nullptr) {
+            if (lf == nullptr || reordered[ld.ld_file_index]) {
                 continue;
             }
 
@@ -801,33 +918,6 @@ logfile_sub_source::rebuild_index(
                   this->lss_index.ba_size,
                   this->lss_index.ba_capacity,
                   remaining);
-        auto filt_row_iter = lower_bound(this->lss_filtered_index.begin(),
-                                         this->lss_filtered_index.end(),
-                                         *lowest_tv,
-                                         filtered_logline_cmp(*this));
-        this->lss_filtered_index.resize(
-            std::distance(this->lss_filtered_index.begin(), filt_row_iter));
-        search_start = vis_line_t(this->lss_filtered_index.size());
-
-        auto bm_range = vis_bm[&textview_curses::BM_USER_EXPR].equal_range(
-            search_start, -1_vl);
-        auto bm_new_size = std::distance(
-            vis_bm[&textview_curses::BM_USER_EXPR].begin(), bm_range.first);
-        vis_bm[&textview_curses::BM_USER_EXPR].resize(bm_new_size);
-
-        if (this->lss_index_delegate) {
-            this->lss_index_delegate->index_start(*this);
-            for (const auto row_in_full_index : this->lss_filtered_index) {
-                auto cl = this->lss_index[row_in_full_index];
-                uint64_t line_number;
-                auto ld_iter = this->find_data(cl, line_number);
-                auto& ld = *ld_iter;
-                auto line_iter = ld->get_file_ptr()->begin() + line_number;
-
-                this->lss_index_delegate->index_line(
-                    *this, ld->get_file_ptr(), line_iter);
-            }
-        }
     }
 
     if (retval != rebuild_result::rr_no_change || force) {
@@ -848,85 +938,147 @@ logfile_sub_source::rebuild_index(
                 = std::max(this->lss_filename_width, lf->get_filename().size());
         }
 
-        if (full_sort) {
-            for (auto& ld : this->lss_files) {
-                auto lf = ld->get_file_ptr();
+        start_size = std::min(start_size, splice_start);
 
-                if (lf == nullptr) {
-                    continue;
-                }
+        kmerge_tree_c<logline, logfile_data, logfile::iterator> merge(
+            file_count);
 
-                for (size_t line_index = 0; line_index < lf->size();
-                     line_index++) {
-                    if ((*lf)[line_index].is_ignored()) {
-                        continue;
-                    }
+        for (iter = this->lss_files.begin(); iter != this->lss_files.end();
+             iter++) {
+            logfile_data* ld = iter->get();
+            auto lf = ld->get_file_ptr();
+            if (lf == nullptr) {
+                continue;
+            }
 
-                    content_line_t con_line(
-                        ld->ld_file_index * MAX_LINES_PER_FILE + line_index);
+            merge.add(ld, lf->begin() + ld->ld_lines_indexed, lf->end());
+            index_size += lf->size();
+        }
 
-                    this->lss_index.push_back(con_line);
-                }
-            }
+        file_off_t index_off = 0;
+        merge.execute();
+        if (this->lss_sorting_observer) {
+            this->lss_sorting_observer(*this, index_off, index_size);
+        }
+        for (;;) {
+            logfile::iterator lf_iter;
+            logfile_data* ld;
 
-            // XXX get rid of this full sort on the initial run, it's not
-            // needed unless the file is not in time-order
-            if (this->lss_sorting_observer) {
-                this->lss_sorting_observer(*this, 0, this->lss_index.size());
-            }
-            std::sort(
-                this->lss_index.begin(), this->lss_index.end(), line_cmper);
-            if (this->lss_sorting_observer) {
-                this->lss_sorting_observer(
-                    *this, this->lss_index.size(), this->lss_index.size());
+            if (!merge.get_top(ld, lf_iter)) {
+                break;
             }
-        } else {
-            kmerge_tree_c<logline, logfile_data, logfile::iterator> merge(
-                file_count);
 
-            for (iter = this->lss_files.begin(); iter != this->lss_files.end();
-                 iter++) {
-                logfile_data* ld = iter->get();
-                auto lf = ld->get_file_ptr();
-                if (lf == nullptr) {
-                    continue;
-                }
+            if (!lf_iter->is_ignored()) {
+                int file_index = ld->ld_file_index;
+                int line_index = lf_iter - ld->get_file_ptr()->begin();
+
+                content_line_t con_line(file_index * MAX_LINES_PER_FILE
+                                        + line_index);
 
-                merge.add(ld, lf->begin() + ld->ld_lines_indexed, lf->end());
-                index_size += lf->size();
+                this->lss_index.push_back(con_line);
             }
 
-            file_off_t index_off = 0;
-            merge.execute();
-            if (this->lss_sorting_observer) {
+            merge.next();
+            index_off += 1;
+            if (index_off % 10000 == 0 && this->lss_sorting_observer) {
                 this->lss_sorting_observer(*this, index_off, index_size);
             }
-            for (;;) {
-                logfile::iterator lf_iter;
-                logfile_data* ld;
+        }
+        if (this->lss_sorting_observer) {
+            this->lss_sorting_observer(*this, index_size, index_size);
+        }
 
-                if (!merge.get_top(ld, lf_iter)) {
-                    break;
+        if (any_reordered) {
+            std::vector<content_line_t> spliced;
+
+            for (auto& ld : this->lss_files) {
+                auto lf = ld->get_file_ptr();
+
+                if (lf == nullptr || !reordered[ld->ld_file_index]) {
+                    continue;
                 }
 
-                if (!lf_iter->is_ignored()) {
-                    int file_index = ld->ld_file_index;
-                    int line_index = lf_iter - ld->get_file_ptr()->begin();
+                std::vector<uint32_t> lines;
 
-                    content_line_t con_line(file_index * MAX_LINES_PER_FILE
-                                            + line_index);
+                lines.reserve(lf->size());
+                for (size_t line_index = 0; line_index < lf->size();
+                     line_index++) {
+                    if (!(*lf)[line_index].is_ignored()) {
+                        lines.push_back(line_index);
+                    }
+                }
+                if (this->lss_sorting_observer) {
+                    this->lss_sorting_observer(*this, 0, lines.size());
+                }
+                sort_file_lines(*lf, lines);
 
-                    this->lss_index.push_back(con_line);
+                auto run_start = spliced.size();
+                for (const auto line_index : lines) {
+                    spliced.emplace_back(ld->ld_file_index * MAX_LINES_PER_FILE
+                                         + line_index);
                 }
+                std::inplace_merge(spliced.begin(),
+                                   spliced.begin() + run_start,
+                                   spliced.end(),
+                                   line_cmper);
+            }
 
-                merge.next();
-                index_off += 1;
-                if (index_off % 10000 == 0 && this->lss_sorting_observer) {
-                    this->lss_sorting_observer(*this, index_off, index_size);
+            if (!spliced.empty()) {
+                auto splice_iter = std::upper_bound(this->lss_index.begin(),
+                                                    this->lss_index.end(),
+                                                    spliced.front(),
+                                                    line_cmper);
+                auto splice_pos
+                    = std::distance(this->lss_index.begin(), splice_iter);
+                auto middle = this->lss_index.size();
+
+                for (const auto cl : spliced) {
+                    this->lss_index.push_back(cl);
                 }
+                std::inplace_merge(this->lss_index.begin() + splice_pos,
+                                   this->lss_index.begin() + middle,
+                                   this->lss_index.end(),
+                                   line_cmper);
+                start_size = std::min(start_size, (size_t) splice_pos);
+                log_debug("spliced %ld reordered rows at %ld",
+                          spliced.size(),
+                          splice_pos);
             }
             if (this->lss_sorting_observer) {
-                this->lss_sorting_observer(*this, index_size, index_size);
+                this->lss_sorting_observer(
+                    *this, this->lss_index.size(), this->lss_index.size());
+            }
+        }
+
+        if (retval == rebuild_result::rr_partial_rebuild) {
+            // Only the rows after start_size have changed, so the filtered
+            // rows before that point can be kept.
+            auto filt_row_iter = std::lower_bound(
+                this->lss_filtered_index.begin(),
+                this->lss_filtered_index.end(),
+                (uint32_t) start_size);
+            this->lss_filtered_index.resize(
+                std::distance(this->lss_filtered_index.begin(), filt_row_iter));
+            search_start = vis_line_t(this->lss_filtered_index.size());
+
+            auto bm_range = vis_bm[&textview_curses::BM_USER_EXPR].equal_range(
+                search_start, -1_vl);
+            auto bm_new_size = std::distance(
+                vis_bm[&textview_curses::BM_USER_EXPR].begin(), bm_range.first);
+            vis_bm[&textview_curses::BM_USER_EXPR].resize(bm_new_size);
+
+            if (this->lss_index_delegate) {
+                this->lss_index_delegate->index_start(*this);
+                for (const auto row_in_full_index : this->lss_filtered_index) {
+                    auto cl = this->lss_index[row_in_full_index];
+                    uint64_t line_number;
+                    auto ld_iter = this->find_data(cl, line_number);
+                    auto& ld = *ld_iter;
+                    auto line_iter = ld->get_file_ptr()->begin() + line_number;
+
+                    this->lss_index_delegate->index_line(
+                        *this, ld->get_file_ptr(), line_iter);
+                }
             }
         }
 
@@ -945,6 +1097,7 @@ logfile_sub_source::rebuild_index(
 
         uint32_t filter_in_mask, filter_out_mask;
         this->get_filters().get_enabled_mask(filter_in_mask, filter_out_mask);
+        this->update_excluded_blocks();
 
         if (start_size == 0 && this->lss_index_delegate != nullptr) {
             this->lss_index_delegate->index_start(*this);
@@ -970,7 +1123,8 @@ logfile_sub_source::rebuild_index(
             }
 
             if (!this->tss_apply_filters
-                || (!(*ld)->ld_filter_state.excluded(
+                || (!(*ld)->is_block_excluded(line_number)
+                    && !(*ld)->ld_filter_state.excluded(
                         filter_in_mask, filter_out_mask, line_number)
                     && this->check_extra_filters(ld, line_iter)))
             {
@@ -1002,6 +1156,13 @@ logfile_sub_source::rebuild_index(
         }
     }
 
+    // The rendered lines are keyed by content line, so they only go stale
+    // when the lines in a file are replaced or reordered.  Appended lines
+    // have new content lines and are not in the cache yet.
+    if (force || any_reordered) {
+        this->invalidate_render_cache();
+    }
+
     switch (retval) {
         case rebuild_result::rr_no_change:
             break;
@@ -1104,9 +1265,37 @@ logfile_sub_source::get_line_accel_direction(vis_line_t vl)
     return la.get_direction();
 }
 
+void
+logfile_sub_source::invalidate_last_message(const logfile_data& ld)
+{
+    auto lf = ld.get_file_ptr();
+
+    if (ld.ld_lines_indexed == 0 || lf == nullptr
+        || ld.ld_lines_indexed > lf->size())
+    {
+        return;
+    }
+
+    auto base_cl = ld.ld_file_index * MAX_LINES_PER_FILE;
+    auto line_number = ld.ld_lines_indexed - 1;
+
+    for (;;) {
+        auto cl = content_line_t(base_cl + line_number);
+
+        this->lss_render_cache.erase(render_cache_key{cl, 0});
+        this->lss_render_cache.erase(render_cache_key{cl, RF_FULL});
+        if (line_number == 0 || !(*lf)[line_number].is_continued()) {
+            break;
+        }
+        line_number -= 1;
+    }
+}
+
 void
 logfile_sub_source::text_filters_changed()
 {
+    this->invalidate_render_cache();
+
     if (this->lss_line_meta_changed) {
         this->invalidate_sql_filter();
         this->lss_line_meta_changed = false;
@@ -1126,6 +1315,7 @@ logfile_sub_source::text_filters_changed()
     uint32_t filtered_in_mask, filtered_out_mask;
 
     this->get_filters().get_enabled_mask(filtered_in_mask, filtered_out_mask);
+    this->update_excluded_blocks();
 
     if (this->lss_index_delegate != nullptr) {
         this->lss_index_delegate->index_start(*this);
@@ -1148,7 +1338,8 @@ logfile_sub_source::text_filters_changed()
         auto line_iter = lf->begin() + line_number;
 
         if (!this->tss_apply_filters
-            || (!(*ld)->ld_filter_state.excluded(
+            || (!(*ld)->is_block_excluded(line_number)
+                && !(*ld)->ld_filter_state.excluded(
                     filtered_in_mask, filtered_out_mask, line_number)
                 && this->check_extra_filters(ld, line_iter)))
         {
@@ -1243,6 +1434,7 @@ logfile_sub_source::insert_file(const std::shared_ptr<logfile>& lf)
         (*existing)->set_file(lf);
     }
     this->lss_force_rebuild = true;
+    this->invalidate_render_cache();
 
     return true;
 }
@@ -1572,6 +1764,26 @@ logfile_sub_source::check_extra_filters(iterator ld, logfile::iterator ll)
     return true;
 }
 
+void
+logfile_sub_source::update_excluded_blocks()
+{
+    auto check_blocks = this->has_block_filters();
+
+    for (auto& ld : this->lss_files) {
+        auto* lf = ld->get_file_ptr();
+
+        if (!check_blocks || lf == nullptr) {
+            ld->ld_excluded_blocks.clear();
+            continue;
+        }
+
+        lf->find_excluded_blocks(this->lss_min_log_level,
+                                 this->lss_min_log_time,
+                                 this->lss_max_log_time,
+                                 ld->ld_excluded_blocks);
+    }
+}
+
 void
 logfile_sub_source::invalidate_sql_filter()
 {
@@ -1596,6 +1808,7 @@ logfile_sub_source::text_mark(const bookmark_type_t* bm,
         logline* ll = this->find_line(cl);
 
         ll->set_mark(added);
+        this->lss_mark_generation += 1;
     }
     lb = std::lower_bound(
         this->lss_user_marks[bm].begin(), this->lss_user_marks[bm].end(), cl);
@@ -1622,6 +1835,7 @@ logfile_sub_source::text_clear_marks(const bookmark_type_t* bm)
     std::vector<content_line_t>::iterator iter;
 
     if (bm == &textview_curses::BM_USER) {
+        this->lss_mark_generation += 1;
         for (iter = this->lss_user_marks[bm].begin();
              iter != this->lss_user_marks[bm].end();)
         {
@@ -1672,6 +1886,7 @@ logfile_sub_source::remove_file(std::shared_ptr<logfile> lf)
         }
 
         this->lss_force_rebuild = true;
+        this->invalidate_render_cache();
     }
 }
 
@@ -42,6 +42,7 @@
 #include <limits.h>
 
 #include "base/lnav_log.hh"
+#include "base/lrucache.hpp"
 #include "base/time_util.hh"
 #include "big_array.hh"
 #include "bookmarks.hh"
@@ -179,6 +180,16 @@ public:
         this->clear_line_size_cache();
     };
 
+    /**
+     * Drop any cached renderings of lines.  This should be called whenever
+     * something that affects the way a line is rendered changes, like the
+     * file contents or the view settings.
+     */
+    void invalidate_render_cache()
+    {
+        this->lss_render_cache.clear();
+    }
+
     void increase_line_context()
     {
         auto old_flags = this->lss_flags;
@@ -258,6 +269,7 @@ public:
     void set_force_rebuild()
     {
         this->lss_force_rebuild = true;
+        this->invalidate_render_cache();
     }
 
     void set_min_log_level(log_level_t level)
@@ -385,6 +397,15 @@ public:
 
     void text_clear_marks(const bookmark_type_t* bm);
 
+    /**
+     * @return A number that is bumped every time a user mark is added or
+     * removed.
+     */
+    uint64_t get_mark_generation() const
+    {
+        return this->lss_mark_generation;
+    }
+
     bool insert_file(const std::shared_ptr<logfile>& lf);
 
     void remove_file(std::shared_ptr<logfile> lf);
@@ -584,10 +605,25 @@ public:
             this->ld_visible = vis;
         }
 
+        /**
+         * @return True if the block containing the given line has no lines
+         *   that can pass the level and time filters.
+         */
+        bool is_block_excluded(uint64_t line_number) const
+        {
+            auto block = line_number / logfile::SUMMARY_BLOCK_SIZE;
+
+            return block < this->ld_excluded_blocks.size()
+                && this->ld_excluded_blocks[block];
+        }
+
         size_t ld_file_index;
         line_filter_observer ld_filter_state;
         size_t ld_lines_indexed{0};
         bool ld_visible;
+        /** The blocks of the file that are excluded by the level and time
+         *  filters, as computed by update_excluded_blocks(). */
+        std::vector<bool> ld_excluded_blocks;
     };
 
     using iterator = std::vector<std::unique_ptr<logfile_data>>::iterator;
@@ -739,6 +775,7 @@ public:
 
 private:
     static const size_t LINE_SIZE_CACHE_SIZE = 512;
+    static const size_t RENDER_CACHE_SIZE = 512;
 
     enum {
         B_SCRUB,
@@ -864,14 +901,56 @@ private:
         std::shared_ptr<logfile> lde_file;
     };
 
+    /**
+     * The state produced by reading and annotating a line in
+     * text_value_for_line() that is kept around so that repaints and
+     * scrolling do not need to redo the work.
+     */
+    struct rendered_line {
+        std::string rl_token_value;
+        std::string rl_value;
+        string_attrs_t rl_attrs;
+        std::vector<logline_value> rl_values;
+        int rl_shift_start{0};
+        int rl_shift_size{0};
+    };
+
+    using render_cache_key = std::pair<content_line_t, line_flags_t>;
+
     void clear_line_size_cache()
     {
         this->lss_line_size_cache.fill(std::make_pair(0, 0));
         this->lss_line_size_cache[0].first = -1;
     };
 
+    /**
+     * @return True if a level or time filter is set, so the block summaries
+     * of the files can be used to rule out lines.
+     */
+    bool has_block_filters() const
+    {
+        return this->lss_min_log_level != LEVEL_UNKNOWN
+            || this->lss_min_log_time.tv_sec != 0
+            || this->lss_min_log_time.tv_usec != 0
+            || this->lss_max_log_time.tv_sec
+            != std::numeric_limits<time_t>::max();
+    }
+
     bool check_extra_filters(iterator ld, logfile::iterator ll);
 
+    /**
+     * Recompute the blocks of each file that cannot pass the level and
+     * time filters so the filtering loops can skip them with a bit test.
+     */
+    void update_excluded_blocks();
+
+    /**
+     * Drop the cached renderings of the last message in a file that was
+     * indexed before new lines were appended, since the message might have
+     * grown.
+     */
+    void invalidate_last_message(const logfile_data& ld);
+
     size_t lss_basename_width = 0;
     size_t lss_filename_width = 0;
     unsigned long lss_flags{0};
@@ -886,6 +965,7 @@ private:
     std::map<content_line_t, bookmark_metadata> lss_user_mark_metadata;
     auto_mem<sqlite3_stmt> lss_marker_stmt{sqlite3_finalize};
     std::string lss_marker_stmt_text;
+    uint64_t lss_mark_generation{0};
 
     line_flags_t lss_token_flags{0};
     iterator lss_token_file_data;
@@ -899,6 +979,8 @@ private:
     logfile::iterator lss_token_line;
     std::array<std::pair<int, size_t>, LINE_SIZE_CACHE_SIZE>
         lss_line_size_cache;
+    cache::lru_cache<render_cache_key, rendered_line> lss_render_cache{
+        RENDER_CACHE_SIZE};
     log_level_t lss_min_log_level{LEVEL_UNKNOWN};
     struct timeval lss_min_log_time {
         0, 0
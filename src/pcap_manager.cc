@@ -29,6 +29,8 @@
  * @file pcap_manager.cc
  */
 
+#include <chrono>
+#include <future>
 #include <memory>
 #include <thread>
 #include <vector>
@@ -37,20 +39,101 @@
 
 #include <unistd.h>
 
+#include "archive_manager.cfg.hh"
 #include "base/fs_util.hh"
+#include "base/injector.hh"
+#include "base/paths.hh"
 #include "config.h"
 #include "line_buffer.hh"
+#include "lnav_util.hh"
 
 namespace pcap_manager {
 
+static ghc::filesystem::path
+pcap_cache_path()
+{
+    return lnav::paths::workdir() / "pcaps";
+}
+
+/**
+ * Compute the name of the cached conversion for a capture.  Hashing a
+ * whole multi-gigabyte capture would take longer than we want to wait, so
+ * the key is built from the size, modification time, and the data at the
+ * start and end of the file.
+ */
+static nonstd::optional<ghc::filesystem::path>
+cache_path_for(const std::string& filename)
+{
+    static const size_t SAMPLE_SIZE = 64 * 1024;
+
+    auto fd = auto_fd(lnav::filesystem::openp(filename, O_RDONLY));
+    struct stat st;
+
+    if (fd == -1 || fstat(fd, &st) == -1) {
+        return nonstd::nullopt;
+    }
+
+    auto fn_path = ghc::filesystem::path(filename);
+    auto buffer = std::make_unique<char[]>(SAMPLE_SIZE);
+    hasher h;
+
+    h.update(fn_path.filename().string());
+    h.update((int64_t) st.st_size);
+    h.update((int64_t) st.st_mtime);
+
+    auto rc = pread(fd, buffer.get(), SAMPLE_SIZE, 0);
+    if (rc > 0) {
+        h.update(buffer.get(), rc);
+    }
+    if (st.st_size > (off_t) SAMPLE_SIZE) {
+        rc = pread(fd, buffer.get(), SAMPLE_SIZE, st.st_size - SAMPLE_SIZE);
+        if (rc > 0) {
+            h.update(buffer.get(), rc);
+        }
+    }
+
+    return pcap_cache_path()
+        / fmt::format(FMT_STRING("pcap-{}.json"), h.to_string());
+}
+
 Result<convert_result, std::string>
 convert(const std::string& filename)
 {
     log_info("attempting to convert pcap file -- %s", filename.c_str());
 
+    auto cache_path_opt = cache_path_for(filename);
+    if (cache_path_opt) {
+        auto cache_path = cache_path_opt.value();
+        auto cached_fd
+            = auto_fd(lnav::filesystem::openp(cache_path, O_RDONLY));
+
+        if (cached_fd != -1) {
+            std::error_code ec;
+
+            log_info("  using cached conversion -- %s", cache_path.c_str());
+            // Touch the file so that the cleanup does not remove it while it
+            // is still in use.
+            ghc::filesystem::last_write_time(
+                cache_path, ghc::filesystem::file_time_type::clock::now(), ec);
+            return Ok(convert_result{
+                nonstd::nullopt,
+                std::move(cached_fd),
+                std::make_shared<std::vector<std::string>>(),
+            });
+        }
+
+        std::error_code ec;
+        ghc::filesystem::create_directories(cache_path.parent_path(), ec);
+    }
+
     auto outfile = TRY(lnav::filesystem::open_temp_file(
-        ghc::filesystem::temp_directory_path() / "lnav.pcap.XXXXXX"));
-    ghc::filesystem::remove(outfile.first);
+        cache_path_opt
+            ? ghc::filesystem::path(cache_path_opt.value().string()
+                                    + ".XXXXXX")
+            : ghc::filesystem::temp_directory_path() / "lnav.pcap.XXXXXX"));
+    if (!cache_path_opt) {
+        ghc::filesystem::remove(outfile.first);
+    }
     auto err_pipe = TRY(auto_pipe::for_child_fd(STDERR_FILENO));
     auto child = TRY(lnav::pid::from_fork());
 
@@ -129,10 +212,74 @@ convert(const std::string& filename)
 
     log_info("started tshark %d to process file", child.in());
 
-    return Ok(convert_result{
+    convert_result retval{
         std::move(child),
         std::move(outfile.second),
         error_queue,
+    };
+
+    if (cache_path_opt) {
+        retval.cr_tmp_path = outfile.first;
+        retval.cr_cache_path = cache_path_opt.value();
+    }
+
+    return Ok(std::move(retval));
+}
+
+void
+finish_conversion(const ghc::filesystem::path& tmp_path,
+                  const ghc::filesystem::path& cache_path,
+                  bool success)
+{
+    std::error_code ec;
+
+    if (tmp_path.empty()) {
+        return;
+    }
+
+    if (!success) {
+        ghc::filesystem::remove(tmp_path, ec);
+        return;
+    }
+
+    // The open descriptor for the temporary file stays valid after the rename.
+    ghc::filesystem::rename(tmp_path, cache_path, ec);
+    if (ec) {
+        log_error("unable to cache pcap conversion %s -- %s",
+                  cache_path.c_str(),
+                  ec.message().c_str());
+        ghc::filesystem::remove(tmp_path, ec);
+    } else {
+        log_info("cached pcap conversion -- %s", cache_path.c_str());
+    }
+}
+
+void
+cleanup_cache()
+{
+    (void) std::async(std::launch::async, []() {
+        auto now = ghc::filesystem::file_time_type::clock::now();
+        auto cache_path = pcap_cache_path();
+        const auto& cfg = injector::get<const archive_manager::config&>();
+        std::vector<ghc::filesystem::path> to_remove;
+        std::error_code ec;
+
+        for (const auto& entry :
+             ghc::filesystem::directory_iterator(cache_path, ec))
+        {
+            auto mtime = ghc::filesystem::last_write_time(entry.path());
+            auto exp_time = mtime + cfg.amc_cache_ttl;
+            if (now < exp_time) {
+                continue;
+            }
+
+            to_remove.emplace_back(entry.path());
+        }
+
+        for (auto& entry : to_remove) {
+            log_debug("removing cached pcap conversion: %s", entry.c_str());
+            ghc::filesystem::remove(entry, ec);
+        }
     });
 }
 
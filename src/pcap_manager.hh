@@ -38,17 +38,34 @@
 #include "base/auto_fd.hh"
 #include "base/auto_pid.hh"
 #include "base/result.h"
+#include "ghc/filesystem.hpp"
+#include "optional.hpp"
 
 namespace pcap_manager {
 
 struct convert_result {
-    auto_pid<process_state::running> cr_child;
+    /** The tshark process, if the capture was not found in the cache. */
+    nonstd::optional<auto_pid<process_state::running>> cr_child;
     auto_fd cr_destination;
     std::shared_ptr<std::vector<std::string>> cr_error_queue;
+    /** The file that tshark is writing to. */
+    ghc::filesystem::path cr_tmp_path;
+    /** Where the output should be moved once tshark succeeds. */
+    ghc::filesystem::path cr_cache_path;
 };
 
 Result<convert_result, std::string> convert(const std::string& filename);
 
+/**
+ * Move the output of a successful conversion into the cache or discard
+ * the output of a failed one.
+ */
+void finish_conversion(const ghc::filesystem::path& tmp_path,
+                       const ghc::filesystem::path& cache_path,
+                       bool success);
+
+void cleanup_cache();
+
 }  // namespace pcap_manager
 
 #endif
@@ -31,6 +31,8 @@
 
 #include "pcrepp.hh"
 
+#include "base/perf_stats.hh"
+
 const int JIT_STACK_MIN_SIZE = 32 * 1024;
 const int JIT_STACK_MAX_SIZE = 512 * 1024;
 
@@ -66,6 +68,180 @@ pcrepp::quote(const char* unquoted)
     return retval;
 }
 
+std::string
+pcrepp::required_literal() const
+{
+    const auto& pat = this->p_pattern;
+    const bool caseless = this->p_options & PCRE_CASELESS;
+    std::string retval, run;
+    bool prev_quantifier = false;
+    int depth = 0;
+
+    if (this->p_options & PCRE_EXTENDED) {
+        return retval;
+    }
+
+    auto end_run = [&retval, &run]() {
+        if (run.size() > retval.size()) {
+            retval = run;
+        }
+        run.clear();
+    };
+
+    for (size_t lpc = 0; lpc < pat.size(); lpc++) {
+        const char ch = pat[lpc];
+        bool is_quantifier = false;
+        int literal = -1;
+
+        switch (ch) {
+            case '\\':
+                lpc += 1;
+                if (lpc >= pat.size()) {
+                    return "";
+                }
+                if (pat[lpc] == 'Q') {
+                    return "";
+                }
+                if (isalnum(pat[lpc])) {
+                    static const char* SIMPLE_ESCAPES
+                        = "dDwWsSbBhHvVRAzZGtnrfea";
+
+                    if (depth == 0
+                        && strchr(SIMPLE_ESCAPES, pat[lpc]) == nullptr)
+                    {
+                        // Escapes that consume more of the pattern.
+                        return "";
+                    }
+                    end_run();
+                } else if (pat[lpc] & 0x80) {
+                    end_run();
+                } else {
+                    literal = pat[lpc];
+                }
+                break;
+            case '[':
+                lpc += 1;
+                if (lpc < pat.size() && pat[lpc] == '^') {
+                    lpc += 1;
+                }
+                if (lpc < pat.size() && pat[lpc] == ']') {
+                    lpc += 1;
+                }
+                while (lpc < pat.size() && pat[lpc] != ']') {
+                    if (pat[lpc] == '\\') {
+                        lpc += 1;
+                    } else if (pat[lpc] == '[' && lpc + 1 < pat.size()
+                               && pat[lpc + 1] == ':')
+                    {
+                        auto close = pat.find(":]", lpc + 2);
+
+                        if (close != std::string::npos) {
+                            lpc = close + 1;
+                        }
+                    }
+                    lpc += 1;
+                }
+                if (lpc >= pat.size()) {
+                    return "";
+                }
+                end_run();
+                break;
+            case '(':
+                if (depth == 0 && lpc + 2 < pat.size() && pat[lpc + 1] == '?'
+                    && strchr("imsxXUJ-", pat[lpc + 2]) != nullptr)
+                {
+                    // Option settings change the meaning of the rest.
+                    return "";
+                }
+                depth += 1;
+                end_run();
+                break;
+            case ')':
+                depth -= 1;
+                break;
+            case '|':
+                if (depth == 0) {
+                    return "";
+                }
+                break;
+            case '.':
+            case '^':
+            case '$':
+                end_run();
+                break;
+            case '*':
+            case '?':
+                is_quantifier = true;
+                if (!prev_quantifier) {
+                    // The previous character is optional.
+                    if (depth == 0 && !run.empty()) {
+                        run.pop_back();
+                    }
+                    end_run();
+                }
+                break;
+            case '+':
+                is_quantifier = true;
+                if (!prev_quantifier) {
+                    end_run();
+                }
+                break;
+            case '{': {
+                size_t end = lpc + 1;
+                bool has_digits = false, has_min = false;
+
+                while (end < pat.size() && isdigit(pat[end])) {
+                    has_digits = true;
+                    if (pat[end] != '0') {
+                        has_min = true;
+                    }
+                    end += 1;
+                }
+                if (has_digits && end < pat.size() && pat[end] == ',') {
+                    end += 1;
+                    while (end < pat.size() && isdigit(pat[end])) {
+                        end += 1;
+                    }
+                }
+                if (!has_digits || end >= pat.size() || pat[end] != '}') {
+                    literal = ch;
+                    break;
+                }
+
+                is_quantifier = true;
+                if (depth == 0 && !has_min && !run.empty()) {
+                    run.pop_back();
+                }
+                end_run();
+                lpc = end;
+                break;
+            }
+            default:
+                if (ch & 0x80) {
+                    end_run();
+                } else {
+                    literal = ch;
+                }
+                break;
+        }
+
+        if (literal != -1 && depth == 0) {
+            if (caseless
+                && (tolower(literal) == 'k' || tolower(literal) == 's'))
+            {
+                // These have non-ASCII case variants in UTF-8 mode.
+                end_run();
+            } else {
+                run.push_back(caseless ? tolower(literal) : literal);
+            }
+        }
+        prev_quantifier = is_quantifier;
+    }
+    end_run();
+
+    return retval;
+}
+
 Result<pcrepp, pcrepp::compile_error>
 pcrepp::from_str(std::string pattern, int options)
 {
@@ -168,6 +344,8 @@ pcrepp::match(pcre_context& pc, pcre_input& pi, int options) const
     const char* str;
     int rc;
 
+    lnav::perf::add(lnav::perf::counter_t::REGEX_EVALS);
+
     pc.set_pcrepp(this);
     pi.pi_offset = pi.pi_next_offset;
 
@@ -306,7 +484,8 @@ pcrepp::study()
         extra->match_limit = 10000;
         extra->match_limit_recursion = 500;
 #ifdef PCRE_STUDY_JIT_COMPILE
-        // pcre_assign_jit_stack(extra, nullptr, jit_stack());
+        pcre_assign_jit_stack(
+            extra, [](void*) { return jit_stack(); }, nullptr);
 #endif
     }
     pcre_fullinfo(
@@ -330,16 +509,20 @@ pcrepp::study()
 }
 
 #ifdef PCRE_STUDY_JIT_COMPILE
+/**
+ * The JIT stack is looked up when a match is executed, so each thread gets
+ * its own stack and the compiled patterns can be shared between threads.
+ */
 pcre_jit_stack*
 pcrepp::jit_stack()
 {
-    static pcre_jit_stack* retval = nullptr;
+    thread_local auto_mem<pcre_jit_stack> retval(pcre_jit_stack_free);
 
     if (retval == nullptr) {
         retval = pcre_jit_stack_alloc(JIT_STACK_MIN_SIZE, JIT_STACK_MAX_SIZE);
     }
 
-    return retval;
+    return retval.in();
 }
 
 #else
@@ -421,6 +421,16 @@ public:
         return quote(unquoted.c_str());
     }
 
+    /**
+     * Find the longest run of literal text that every match of this pattern
+     * has to contain.  The analysis is conservative and gives up on
+     * alternations and constructs it does not understand.
+     *
+     * @return The literal, lower-cased if the pattern is caseless, or an
+     * empty string if one could not be found.
+     */
+    std::string required_literal() const;
+
     struct compile_error {
         const char* ce_msg;
         int ce_offset;
@@ -610,6 +620,11 @@ public:
         return "";
     };
 
+    unsigned long get_options() const
+    {
+        return this->p_options;
+    }
+
     int get_capture_count() const
     {
         return this->p_capture_count;
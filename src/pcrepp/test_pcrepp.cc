@@ -170,5 +170,16 @@ main(int argc, char* argv[])
         assert(re.captures()[0].c_end == 11);
     }
 
+    {
+        assert(pcrepp("foo.*bar").required_literal() == "foo");
+        assert(pcrepp("abc?d").required_literal() == "ab");
+        assert(pcrepp("(foo|bar)baz").required_literal() == "baz");
+        assert(pcrepp("foo|bar").required_literal().empty());
+        assert(pcrepp("a{2}b{0,3}cd").required_literal() == "cd");
+        assert(pcrepp("\\d+ error \\w+").required_literal() == " error ");
+        assert(pcrepp("(?i)error").required_literal().empty());
+        assert(pcrepp("Error", PCRE_CASELESS).required_literal() == "error");
+    }
+
     return retval;
 }
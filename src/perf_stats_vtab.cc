@@ -0,0 +1,116 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "base/injector.bind.hh"
+#include "base/perf_stats.hh"
+#include "config.h"
+#include "vtab_module.hh"
+
+struct lnav_perf_stats : public tvt_iterator_cursor<lnav_perf_stats> {
+    static constexpr const char* NAME = "lnav_perf_stats";
+    static constexpr const char* CREATE_STMT = R"(
+-- Access lnav's internal performance counters through this table.
+CREATE TABLE lnav_perf_stats (
+    name        TEXT,     -- The name of the counter.
+    description TEXT,     -- A description of what is being counted.
+    count       INTEGER,  -- The number of events or amount counted.
+    total_us    INTEGER,  -- The total time spent, in microseconds.
+    mean_us     REAL,     -- The mean time per event, in microseconds.
+    p50_us      INTEGER,  -- The median time per event, in microseconds.
+    p95_us      INTEGER,  -- The 95th percentile time, in microseconds.
+    p99_us      INTEGER,  -- The 99th percentile time, in microseconds.
+    max_us      INTEGER   -- The longest time for one event, in microseconds.
+);
+)";
+
+    using iterator = const lnav::perf::counter_info*;
+
+    iterator begin()
+    {
+        return lnav::perf::counter_infos();
+    }
+
+    iterator end()
+    {
+        return lnav::perf::counter_infos() + lnav::perf::COUNTER_COUNT;
+    }
+
+    int get_column(cursor& vc, sqlite3_context* ctx, int col)
+    {
+        const auto& ci = *vc.iter;
+        const auto& c = lnav::perf::get_counter(ci.ci_id);
+        auto timed_count = c.c_timed_count.load(std::memory_order_relaxed);
+
+        switch (col) {
+            case 0:
+                sqlite3_result_text(ctx, ci.ci_name, -1, SQLITE_STATIC);
+                return SQLITE_OK;
+            case 1:
+                sqlite3_result_text(ctx, ci.ci_description, -1, SQLITE_STATIC);
+                return SQLITE_OK;
+            case 2:
+                to_sqlite(ctx, c.c_count.load(std::memory_order_relaxed));
+                return SQLITE_OK;
+        }
+
+        if (timed_count == 0) {
+            sqlite3_result_null(ctx);
+            return SQLITE_OK;
+        }
+
+        auto total_us = c.c_total_us.load(std::memory_order_relaxed);
+
+        switch (col) {
+            case 3:
+                to_sqlite(ctx, total_us);
+                break;
+            case 4:
+                to_sqlite(ctx, (double) total_us / (double) timed_count);
+                break;
+            case 5:
+                to_sqlite(ctx, c.percentile_us(0.50));
+                break;
+            case 6:
+                to_sqlite(ctx, c.percentile_us(0.95));
+                break;
+            case 7:
+                to_sqlite(ctx, c.percentile_us(0.99));
+                break;
+            case 8:
+                to_sqlite(ctx, c.c_max_us.load(std::memory_order_relaxed));
+                break;
+        }
+
+        return SQLITE_OK;
+    }
+};
+
+static auto perf_binder
+    = injector::bind_multiple<vtab_module_base>()
+          .add<vtab_module<tvt_no_update<lnav_perf_stats>>>();
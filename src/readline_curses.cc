@@ -76,6 +76,32 @@ static const int HISTORY_SIZE = 256;
 static int completion_start;
 static const int FUZZY_PEER_THRESHOLD = 30;
 
+/**
+ * The largest message used to send a batch of possibilities to the child.
+ */
+static const size_t MAX_POSSIBILITY_BATCH_SIZE = 32 * 1024;
+
+static const char POSSIBILITY_SEPARATOR = '\x1e';
+
+static std::vector<std::string>
+split_possibilities(const char* values)
+{
+    std::vector<std::string> retval;
+
+    while (*values) {
+        const char* sep = strchr(values, POSSIBILITY_SEPARATOR);
+
+        if (sep == nullptr) {
+            retval.emplace_back(values);
+            break;
+        }
+        retval.emplace_back(values, sep);
+        values = sep + 1;
+    }
+
+    return retval;
+}
+
 static const char* RL_INIT[] = {
     /*
      * XXX Need to keep the input on a single line since the display screws
@@ -846,7 +872,7 @@ readline_curses::start()
                 }
             }
             if (FD_ISSET(this->rc_command_pipe[RCF_SLAVE], &ready_rfds)) {
-                char msg[1024 + 1];
+                char msg[MAX_POSSIBILITY_BATCH_SIZE + 1];
 
                 if ((rc = recvstring(this->rc_command_pipe[RCF_SLAVE],
                                      msg,
@@ -930,6 +956,40 @@ readline_curses::start()
                         this->rc_contexts[context]
                             ->rc_prefixes[std::string(type)]
                             = std::string(&msg[prompt_start]);
+                    } else if (sscanf(msg,
+                                      "apb:%d:%31[^:]:%n",
+                                      &context,
+                                      type,
+                                      &prompt_start)
+                               == 2) {
+                        require(this->rc_contexts[context] != nullptr);
+
+                        auto* rc_ctx = this->rc_contexts[context];
+
+                        for (const auto& value :
+                             split_possibilities(&msg[prompt_start]))
+                        {
+                            rc_ctx->add_possibility(std::string(type), value);
+                        }
+                        if (rl_last_func == rl_complete
+                            || rl_last_func == rl_menu_complete) {
+                            rl_last_func = NULL;
+                        }
+                    } else if (sscanf(msg,
+                                      "rpb:%d:%31[^:]:%n",
+                                      &context,
+                                      type,
+                                      &prompt_start)
+                               == 2) {
+                        require(this->rc_contexts[context] != nullptr);
+
+                        auto* rc_ctx = this->rc_contexts[context];
+
+                        for (const auto& value :
+                             split_possibilities(&msg[prompt_start]))
+                        {
+                            rc_ctx->rem_possibility(std::string(type), value);
+                        }
                     } else if (sscanf(msg,
                                       "ap:%d:%31[^:]:%n",
                                       &context,
@@ -1224,6 +1284,8 @@ readline_curses::focus(int context,
 {
     char buffer[1024];
 
+    this->flush_possibilities();
+
     curs_set(1);
 
     this->rc_active_context = context;
@@ -1312,23 +1374,15 @@ readline_curses::add_possibility(int context,
                                  const std::string& type,
                                  const std::string& value)
 {
-    char buffer[1024];
-
     if (value.empty()) {
         return;
     }
 
-    snprintf(buffer,
-             sizeof(buffer),
-             "ap:%d:%s:%s",
-             context,
-             type.c_str(),
-             value.c_str());
-    if (sendstring(
-            this->rc_command_pipe[RCF_MASTER], buffer, strlen(buffer) + 1)
-        == -1)
-    {
-        perror("add_possibility: write failed");
+    auto& ps = this->rc_possibility_state[std::make_pair(context, type)];
+
+    if (ps.ps_local.insert(value).second) {
+        ps.ps_forced_removals.erase(value);
+        ps.ps_dirty = true;
     }
 }
 
@@ -1337,33 +1391,142 @@ readline_curses::rem_possibility(int context,
                                  const std::string& type,
                                  const std::string& value)
 {
-    char buffer[1024];
+    auto& ps = this->rc_possibility_state[std::make_pair(context, type)];
 
-    snprintf(buffer,
-             sizeof(buffer),
-             "rp:%d:%s:%s",
-             context,
-             type.c_str(),
-             value.c_str());
-    if (sendstring(
-            this->rc_command_pipe[RCF_MASTER], buffer, strlen(buffer) + 1)
-        == -1)
-    {
-        perror("rem_possiblity: write failed");
+    ps.ps_local.erase(value);
+    if (ps.ps_remote_unknown) {
+        ps.ps_forced_removals.insert(value);
     }
+    ps.ps_dirty = true;
 }
 
 void
 readline_curses::clear_possibilities(int context, std::string type)
 {
-    char buffer[1024];
+    auto& ps = this->rc_possibility_state[std::make_pair(context, type)];
 
-    snprintf(buffer, sizeof(buffer), "cp:%d:%s", context, type.c_str());
-    if (sendstring(
-            this->rc_command_pipe[RCF_MASTER], buffer, strlen(buffer) + 1)
-        == -1)
-    {
-        perror("clear_possiblity: write failed");
+    ps.ps_local.clear();
+    ps.ps_forced_removals.clear();
+    if (ps.ps_remote_unknown) {
+        ps.ps_clear_pending = true;
+    }
+    ps.ps_dirty = true;
+}
+
+void
+readline_curses::send_possibility_batch(const char* cmd,
+                                        int context,
+                                        const std::string& type,
+                                        const std::vector<std::string>& values)
+{
+    auto header = fmt::format(FMT_STRING("{}:{}:{}:"), cmd, context, type);
+    std::string buffer;
+
+    // The sizes below include the NUL terminator that is sent along with
+    // the message, the child cannot receive more than the batch size.
+    for (const auto& value : values) {
+        if (header.size() + value.size() + 1 > MAX_POSSIBILITY_BATCH_SIZE) {
+            log_warning("possibility is too large to send: %zu",
+                        value.size());
+            continue;
+        }
+        if (value.find(POSSIBILITY_SEPARATOR) != std::string::npos) {
+            // The child would split the value into separate possibilities.
+            log_warning("possibility contains a separator, not sending: %s",
+                        value.c_str());
+            continue;
+        }
+        if (!buffer.empty()
+            && buffer.size() + 1 + value.size() + 1
+                > MAX_POSSIBILITY_BATCH_SIZE)
+        {
+            if (sendstring(this->rc_command_pipe[RCF_MASTER],
+                           buffer.c_str(),
+                           buffer.size() + 1)
+                == -1)
+            {
+                perror("send_possibility_batch: write failed");
+            }
+            buffer.clear();
+        }
+        if (buffer.empty()) {
+            buffer = header;
+        } else {
+            buffer.push_back(POSSIBILITY_SEPARATOR);
+        }
+        buffer.append(value);
+    }
+    if (!buffer.empty()) {
+        if (sendstring(this->rc_command_pipe[RCF_MASTER],
+                       buffer.c_str(),
+                       buffer.size() + 1)
+            == -1)
+        {
+            perror("send_possibility_batch: write failed");
+        }
+    }
+}
+
+void
+readline_curses::flush_possibilities()
+{
+    for (auto& pair : this->rc_possibility_state) {
+        auto& ps = pair.second;
+
+        if (!ps.ps_dirty) {
+            continue;
+        }
+
+        auto context = pair.first.first;
+        const auto& type = pair.first.second;
+        std::vector<std::string> removals;
+        std::vector<std::string> additions;
+
+        std::set_difference(ps.ps_remote.begin(),
+                            ps.ps_remote.end(),
+                            ps.ps_local.begin(),
+                            ps.ps_local.end(),
+                            std::back_inserter(removals));
+        removals.insert(removals.end(),
+                        ps.ps_forced_removals.begin(),
+                        ps.ps_forced_removals.end());
+        if (!ps.ps_remote_unknown && !removals.empty()
+            && removals.size() >= ps.ps_local.size())
+        {
+            // Cheaper to start over than to remove most of the values.
+            ps.ps_clear_pending = true;
+        }
+
+        if (ps.ps_clear_pending) {
+            char buffer[1024];
+
+            snprintf(
+                buffer, sizeof(buffer), "cp:%d:%s", context, type.c_str());
+            if (sendstring(this->rc_command_pipe[RCF_MASTER],
+                           buffer,
+                           strlen(buffer) + 1)
+                == -1)
+            {
+                perror("clear_possiblity: write failed");
+            }
+            ps.ps_remote.clear();
+            ps.ps_remote_unknown = false;
+            ps.ps_clear_pending = false;
+            removals.clear();
+        }
+
+        std::set_difference(ps.ps_local.begin(),
+                            ps.ps_local.end(),
+                            ps.ps_remote.begin(),
+                            ps.ps_remote.end(),
+                            std::back_inserter(additions));
+
+        this->send_possibility_batch("rpb", context, type, removals);
+        this->send_possibility_batch("apb", context, type, additions);
+
+        ps.ps_remote = ps.ps_local;
+        ps.ps_forced_removals.clear();
+        ps.ps_dirty = false;
     }
 }
 
@@ -163,6 +163,7 @@ public:
 
     void update_poll_set(std::vector<struct pollfd>& pollfds)
     {
+        this->flush_possibilities();
         pollfds.push_back((struct pollfd){this->rc_pty[RCF_MASTER], POLLIN, 0});
         pollfds.push_back(
             (struct pollfd){this->rc_command_pipe[RCF_MASTER], POLLIN, 0});
@@ -256,6 +257,13 @@ public:
                          const std::string& value);
     void clear_possibilities(int context, std::string type);
 
+    /**
+     * Send the changes made to the possibilities since the last call to the
+     * child process.  Changes are buffered so that the vocabularies can be
+     * sent in bulk and values the child already has are not resent.
+     */
+    void flush_possibilities();
+
     const std::vector<std::string>& get_matches() const
     {
         return this->rc_matches;
@@ -296,6 +304,24 @@ private:
 
     static void store_matches(char** matches, int num_matches, int max_len);
 
+    struct possibility_state {
+        /** The values that should be in the child. */
+        std::set<std::string> ps_local;
+        /** The values that have been sent to the child. */
+        std::set<std::string> ps_remote;
+        /** Values to remove that the child might have gotten elsewhere. */
+        std::set<std::string> ps_forced_removals;
+        /** True if the child could have values that were not sent by us. */
+        bool ps_remote_unknown{true};
+        bool ps_clear_pending{false};
+        bool ps_dirty{false};
+    };
+
+    void send_possibility_batch(const char* cmd,
+                                int context,
+                                const std::string& type,
+                                const std::vector<std::string>& values);
+
     friend class readline_context;
 
     int rc_active_context{-1};
@@ -315,6 +341,8 @@ private:
     bool rc_is_alt_focus{false};
     bool rc_ready_for_input{false};
     std::string rc_remote_complete_path;
+    std::map<std::pair<int, std::string>, possibility_state>
+        rc_possibility_state;
 
     action rc_focus;
     action rc_change;
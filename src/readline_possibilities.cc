@@ -27,8 +27,11 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <map>
 #include <regex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "readline_possibilities.hh"
 
@@ -115,15 +118,44 @@ struct sqlite_metadata_callbacks lnav_sql_meta_callbacks = {
     handle_foreign_key_list,
 };
 
+static void
+add_token_possibility(readline_curses* rlc,
+                      int context,
+                      const std::string& type,
+                      const std::string& token)
+{
+    static const std::regex re_escape(R"(([.\^$*+?()\[\]{}\\|]))");
+    static const std::regex re_escape_no_dot(R"(([\^$*+?()\[\]{}\\|]))");
+
+    switch (context) {
+        case LNM_SQL: {
+            auto_mem<char, sqlite3_free> quoted_token;
+
+            quoted_token = sqlite3_mprintf("%Q", token.c_str());
+            rlc->add_possibility(context, type, std::string(quoted_token));
+            break;
+        }
+        default: {
+            std::string token_value, token_value_no_dot;
+
+            token_value = std::regex_replace(token, re_escape, R"(\\\1)");
+            token_value_no_dot
+                = std::regex_replace(token, re_escape_no_dot, R"(\\\1)");
+            rlc->add_possibility(context, type, token_value);
+            if (token_value != token_value_no_dot) {
+                rlc->add_possibility(context, type, token_value_no_dot);
+            }
+            break;
+        }
+    }
+}
+
 static void
 add_text_possibilities(readline_curses* rlc,
                        int context,
                        const std::string& type,
                        const std::string& str)
 {
-    static const std::regex re_escape(R"(([.\^$*+?()\[\]{}\\|]))");
-    static const std::regex re_escape_no_dot(R"(([\^$*+?()\[\]{}\\|]))");
-
     pcre_context_static<30> pc;
     data_scanner ds(str);
     data_token_t dt;
@@ -142,31 +174,8 @@ add_text_possibilities(readline_curses* rlc,
                 break;
         }
 
-        switch (context) {
-            case LNM_SQL: {
-                auto token_value = ds.get_input().get_substr(pc.all());
-                auto_mem<char, sqlite3_free> quoted_token;
-
-                quoted_token = sqlite3_mprintf("%Q", token_value.c_str());
-                rlc->add_possibility(context, type, std::string(quoted_token));
-                break;
-            }
-            default: {
-                std::string token_value, token_value_no_dot;
-
-                token_value_no_dot = token_value
-                    = ds.get_input().get_substr(pc.all());
-                token_value
-                    = std::regex_replace(token_value, re_escape, R"(\\\1)");
-                token_value_no_dot = std::regex_replace(
-                    token_value_no_dot, re_escape_no_dot, R"(\\\1)");
-                rlc->add_possibility(context, type, token_value);
-                if (token_value != token_value_no_dot) {
-                    rlc->add_possibility(context, type, token_value_no_dot);
-                }
-                break;
-            }
-        }
+        add_token_possibility(
+            rlc, context, type, ds.get_input().get_substr(pc.all()));
 
         switch (dt) {
             case DT_QUOTED_STRING:
@@ -179,6 +188,172 @@ add_text_possibilities(readline_curses* rlc,
     }
 }
 
+namespace {
+
+enum vocab_class_t {
+    VOCAB_WORDS,
+    VOCAB_ADDRESSES,
+    VOCAB_IDS,
+    VOCAB_PATHS,
+
+    VOCAB__MAX
+};
+
+/**
+ * A capped heavy-hitters sketch of token frequencies.  Once the number of
+ * distinct tokens grows past twice the capacity, the least frequent ones
+ * are dropped, so rare tokens are forgotten but common ones survive.
+ */
+class token_sketch {
+public:
+    static const size_t CAPACITY = 512;
+
+    void add(const std::string& token)
+    {
+        this->ts_counts[token] += 1;
+        if (this->ts_counts.size() > CAPACITY * 2) {
+            this->prune();
+        }
+    }
+
+    std::vector<std::string> top(size_t count) const
+    {
+        auto sorted = this->sorted_counts();
+        std::vector<std::string> retval;
+
+        for (const auto& pair : sorted) {
+            if (retval.size() >= count) {
+                break;
+            }
+            retval.emplace_back(pair.first);
+        }
+
+        return retval;
+    }
+
+private:
+    std::vector<std::pair<std::string, size_t>> sorted_counts() const
+    {
+        std::vector<std::pair<std::string, size_t>> retval(
+            this->ts_counts.begin(), this->ts_counts.end());
+
+        std::stable_sort(
+            retval.begin(), retval.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.second > rhs.second;
+            });
+
+        return retval;
+    }
+
+    void prune()
+    {
+        auto sorted = this->sorted_counts();
+
+        sorted.resize(CAPACITY);
+        this->ts_counts.clear();
+        this->ts_counts.insert(sorted.begin(), sorted.end());
+    }
+
+    std::unordered_map<std::string, size_t> ts_counts;
+};
+
+struct vocabulary_index {
+    token_sketch vi_sketches[VOCAB__MAX];
+    /** The next line to scan in each file, keyed by file name. */
+    std::map<std::string, size_t> vi_positions;
+
+    void add_line(const std::string& line)
+    {
+        static const size_t MAX_TOKEN_LEN = 128;
+
+        pcre_context_static<30> pc;
+        data_scanner ds(line);
+        data_token_t dt;
+
+        while (ds.tokenize2(pc, dt)) {
+            if (pc[0]->length() < 4 || pc[0]->length() > MAX_TOKEN_LEN) {
+                continue;
+            }
+
+            auto vclass = VOCAB__MAX;
+
+            switch (dt) {
+                case DT_WORD:
+                case DT_SYMBOL:
+                case DT_CONSTANT:
+                    vclass = VOCAB_WORDS;
+                    break;
+                case DT_IPV4_ADDRESS:
+                case DT_IPV6_ADDRESS:
+                case DT_MAC_ADDRESS:
+                case DT_EMAIL:
+                    vclass = VOCAB_ADDRESSES;
+                    break;
+                case DT_UUID:
+                case DT_HEX_NUMBER:
+                    vclass = VOCAB_IDS;
+                    break;
+                case DT_PATH:
+                case DT_URL:
+                    vclass = VOCAB_PATHS;
+                    break;
+                case DT_QUOTED_STRING:
+                    this->add_line(ds.get_input().get_substr(pc[0]));
+                    break;
+                default:
+                    break;
+            }
+
+            if (vclass != VOCAB__MAX) {
+                this->vi_sketches[vclass].add(
+                    ds.get_input().get_substr(pc.all()));
+            }
+        }
+    }
+};
+
+vocabulary_index&
+get_vocabulary_index()
+{
+    static vocabulary_index retval;
+
+    return retval;
+}
+
+}  // namespace
+
+void
+index_vocabulary(ui_clock::time_point deadline)
+{
+    static const size_t CHECK_INTERVAL = 128;
+
+    auto& vi = get_vocabulary_index();
+    size_t lines_scanned = 0;
+
+    for (const auto& lf : lnav_data.ld_active_files.fc_files) {
+        auto& pos = vi.vi_positions[lf->get_filename()];
+
+        if (pos > lf->size()) {
+            // The file was truncated, start over.
+            pos = 0;
+        }
+        while (pos < lf->size()) {
+            auto read_res = lf->read_line(lf->begin() + pos);
+
+            pos += 1;
+            if (read_res.isOk()) {
+                vi.add_line(to_string(read_res.unwrap()));
+            }
+            lines_scanned += 1;
+            if ((lines_scanned % CHECK_INTERVAL) == 0
+                && ui_clock::now() >= deadline)
+            {
+                return;
+            }
+        }
+    }
+}
+
 void
 add_view_text_possibilities(readline_curses* rlc,
                             int context,
@@ -199,6 +374,15 @@ add_view_text_possibilities(readline_curses* rlc,
         add_text_possibilities(rlc, context, type, line);
     }
 
+    // Fill in the rest of the vocabulary from the whole session.
+    static const size_t MAX_TOKENS_PER_CLASS = 128;
+
+    for (const auto& sketch : get_vocabulary_index().vi_sketches) {
+        for (const auto& token : sketch.top(MAX_TOKENS_PER_CLASS)) {
+            add_token_possibility(rlc, context, type, token);
+        }
+    }
+
     rlc->add_possibility(context, type, bookmark_metadata::KNOWN_TAGS);
 }
 
@@ -32,6 +32,7 @@
 
 #include <string>
 
+#include "logfile_fwd.hh"
 #include "readline_curses.hh"
 #include "textview_curses.hh"
 
@@ -50,6 +51,14 @@ void add_tag_possibilities();
 void add_file_possibilities();
 void add_recent_netlocs_possibilities();
 
+/**
+ * Incrementally scan the lines in the loaded files to build the
+ * vocabulary used for completing search and filter expressions.
+ *
+ * @param deadline The time at which scanning should stop.
+ */
+void index_vocabulary(ui_clock::time_point deadline);
+
 extern struct sqlite_metadata_callbacks lnav_sql_meta_callbacks;
 
 #endif  // LNAV_READLINE_POSSIBILITIES_H
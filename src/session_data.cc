@@ -30,6 +30,7 @@
  */
 
 #include <algorithm>
+#include <unordered_map>
 #include <utility>
 
 #include "session_data.hh"
@@ -74,6 +75,9 @@ CREATE TABLE IF NOT EXISTS bookmarks (
     PRIMARY KEY (log_time, log_format, log_hash, session_time)
 );
 
+CREATE INDEX IF NOT EXISTS bookmarks_format_time
+    ON bookmarks (log_format, log_time);
+
 CREATE TABLE IF NOT EXISTS time_offset (
     log_time datetime,
     log_format varchar(64),
@@ -86,6 +90,9 @@ CREATE TABLE IF NOT EXISTS time_offset (
     PRIMARY KEY (log_time, log_format, log_hash, session_time)
 );
 
+CREATE INDEX IF NOT EXISTS time_offset_format_time
+    ON time_offset (log_format, log_time);
+
 CREATE TABLE IF NOT EXISTS recent_netlocs (
     netloc text,
 
@@ -108,6 +115,10 @@ static const char* NETLOC_LRU_STMT
 static const char* UPGRADE_STMTS[] = {
     R"(ALTER TABLE bookmarks ADD COLUMN comment text DEFAULT '';)",
     R"(ALTER TABLE bookmarks ADD COLUMN tags text DEFAULT '';)",
+    R"(CREATE INDEX IF NOT EXISTS bookmarks_format_time
+         ON bookmarks (log_format, log_time);)",
+    R"(CREATE INDEX IF NOT EXISTS time_offset_format_time
+         ON time_offset (log_format, log_time);)",
 };
 
 static const size_t MAX_SESSIONS = 8;
@@ -412,6 +423,64 @@ scan_sessions()
     return nonstd::make_optional(session_file_names.back());
 }
 
+struct saved_bookmark {
+    struct timeval sb_log_tv {
+        0, 0
+    };
+    std::string sb_log_hash;
+    int64_t sb_session_time{0};
+    bool sb_has_part_name{false};
+    std::string sb_part_name;
+    std::string sb_comment;
+    std::string sb_tags;
+};
+
+static void
+restore_user_mark(content_line_t line_cl, const saved_bookmark& sb)
+{
+    logfile_sub_source& lss = lnav_data.ld_log_source;
+    std::map<content_line_t, bookmark_metadata>& bm_meta
+        = lss.get_user_bookmark_metadata();
+    bool meta = false;
+
+    if (!sb.sb_part_name.empty()) {
+        lss.set_user_mark(&textview_curses::BM_META, line_cl);
+        bm_meta[line_cl].bm_name = sb.sb_part_name;
+        meta = true;
+    }
+    if (!sb.sb_comment.empty()) {
+        lss.set_user_mark(&textview_curses::BM_META, line_cl);
+        bm_meta[line_cl].bm_comment = sb.sb_comment;
+        meta = true;
+    }
+    if (!sb.sb_tags.empty()) {
+        auto_mem<yajl_val_s> tag_list(yajl_tree_free);
+        char error_buffer[1024];
+
+        tag_list = yajl_tree_parse(
+            sb.sb_tags.c_str(), error_buffer, sizeof(error_buffer));
+        if (!YAJL_IS_ARRAY(tag_list.in())) {
+            log_error("invalid tags column: %s", sb.sb_tags.c_str());
+        } else {
+            lss.set_user_mark(&textview_curses::BM_META, line_cl);
+            for (size_t lpc = 0; lpc < tag_list.in()->u.array.len; lpc++) {
+                yajl_val elem = tag_list.in()->u.array.values[lpc];
+
+                if (!YAJL_IS_STRING(elem)) {
+                    continue;
+                }
+                bookmark_metadata::KNOWN_TAGS.insert(elem->u.string);
+                bm_meta[line_cl].add_tag(elem->u.string);
+            }
+        }
+        meta = true;
+    }
+    if (!meta) {
+        marked_session_lines.push_back(line_cl);
+        lss.set_user_mark(&textview_curses::BM_USER, line_cl);
+    }
+}
+
 void
 load_time_bookmarks()
 {
@@ -467,16 +536,13 @@ load_time_bookmarks()
         }
     }
 
-    if (sqlite3_prepare_v2(
-            db.in(),
-            "SELECT log_time, log_format, log_hash, session_time, part_name, "
-            "access_time, comment,"
-            " tags, session_time=? as same_session FROM bookmarks WHERE "
-            " log_time between ? and ? and log_format = ? "
-            " ORDER BY same_session DESC, session_time DESC",
-            -1,
-            stmt.out(),
-            nullptr)
+    if (sqlite3_prepare_v2(db.in(),
+                           "SELECT log_time, log_hash, session_time, "
+                           "part_name, comment, tags FROM bookmarks "
+                           "WHERE log_format = ? ORDER BY log_time",
+                           -1,
+                           stmt.out(),
+                           nullptr)
         != SQLITE_OK)
     {
         log_error("could not prepare bookmark select statement -- %s",
@@ -484,38 +550,36 @@ load_time_bookmarks()
         return;
     }
 
+    /*
+     * Load the saved bookmarks for each format once, instead of querying for
+     * each file, so that they can be joined against the files in a batch.
+     */
+    std::map<std::string, std::vector<saved_bookmark>> format_marks;
+    date_time_scanner dts;
+
     for (file_iter = lnav_data.ld_log_source.begin();
          file_iter != lnav_data.ld_log_source.end();
          ++file_iter)
     {
         auto lf = (*file_iter)->get_file();
-        content_line_t base_content_line;
 
         if (lf == nullptr) {
             continue;
         }
 
-        base_content_line = lss.get_file_base_content_line(file_iter);
+        auto format_name = lf->get_format()->get_name().to_string();
 
-        auto low_line_iter = lf->begin();
-        auto high_line_iter = lf->end();
+        if (format_marks.count(format_name) > 0) {
+            continue;
+        }
 
-        --high_line_iter;
+        auto& marks = format_marks[format_name];
 
-        if (bind_values(stmt.in(),
-                        lnav_data.ld_session_load_time,
-                        lf->original_line_time(low_line_iter),
-                        lf->original_line_time(high_line_iter),
-                        lf->get_format()->get_name())
-            != SQLITE_OK)
-        {
+        if (bind_values(stmt.in(), format_name) != SQLITE_OK) {
             return;
         }
 
-        date_time_scanner dts;
         bool done = false;
-        std::string line;
-        int64_t last_mark_time = -1;
 
         while (!done) {
             int rc = sqlite3_step(stmt.in());
@@ -530,117 +594,39 @@ load_time_bookmarks()
                     const char* log_time
                         = (const char*) sqlite3_column_text(stmt.in(), 0);
                     const char* log_hash
-                        = (const char*) sqlite3_column_text(stmt.in(), 2);
+                        = (const char*) sqlite3_column_text(stmt.in(), 1);
                     const char* part_name
-                        = (const char*) sqlite3_column_text(stmt.in(), 4);
+                        = (const char*) sqlite3_column_text(stmt.in(), 3);
                     const char* comment
-                        = (const char*) sqlite3_column_text(stmt.in(), 6);
+                        = (const char*) sqlite3_column_text(stmt.in(), 4);
                     const char* tags
-                        = (const char*) sqlite3_column_text(stmt.in(), 7);
-                    int64_t mark_time = sqlite3_column_int64(stmt.in(), 3);
-                    struct timeval log_tv;
+                        = (const char*) sqlite3_column_text(stmt.in(), 5);
+                    saved_bookmark sb;
                     struct exttm log_tm;
 
-                    if (last_mark_time == -1) {
-                        last_mark_time = mark_time;
-                    } else if (last_mark_time != mark_time) {
-                        done = true;
+                    if (log_time == nullptr || log_hash == nullptr
+                        || !dts.scan(log_time,
+                                     strlen(log_time),
+                                     nullptr,
+                                     &log_tm,
+                                     sb.sb_log_tv))
+                    {
                         continue;
                     }
 
-                    if (part_name == nullptr) {
-                        continue;
+                    sb.sb_log_hash = log_hash;
+                    sb.sb_session_time = sqlite3_column_int64(stmt.in(), 2);
+                    if (part_name != nullptr) {
+                        sb.sb_has_part_name = true;
+                        sb.sb_part_name = part_name;
                     }
-
-                    if (!dts.scan(
-                            log_time, strlen(log_time), NULL, &log_tm, log_tv))
-                    {
-                        continue;
+                    if (comment != nullptr) {
+                        sb.sb_comment = comment;
                     }
-
-                    auto line_iter
-                        = lower_bound(lf->begin(), lf->end(), log_tv);
-                    while (line_iter != lf->end()) {
-                        struct timeval line_tv = line_iter->get_timeval();
-
-                        if ((line_tv.tv_sec != log_tv.tv_sec)
-                            || (line_tv.tv_usec != log_tv.tv_usec)) {
-                            break;
-                        }
-
-                        auto cl = content_line_t(
-                            std::distance(lf->begin(), line_iter));
-                        auto read_result = lf->read_line(line_iter);
-
-                        if (read_result.isErr()) {
-                            break;
-                        }
-
-                        auto sbr = read_result.unwrap();
-
-                        auto line_hash
-                            = hasher()
-                                  .update(sbr.get_data(), sbr.length())
-                                  .update(cl)
-                                  .to_string();
-
-                        if (line_hash == log_hash) {
-                            content_line_t line_cl = content_line_t(
-                                base_content_line
-                                + std::distance(lf->begin(), line_iter));
-                            bool meta = false;
-
-                            if (part_name != nullptr && part_name[0] != '\0') {
-                                lss.set_user_mark(&textview_curses::BM_META,
-                                                  line_cl);
-                                bm_meta[line_cl].bm_name = part_name;
-                                meta = true;
-                            }
-                            if (comment != nullptr && comment[0] != '\0') {
-                                lss.set_user_mark(&textview_curses::BM_META,
-                                                  line_cl);
-                                bm_meta[line_cl].bm_comment = comment;
-                                meta = true;
-                            }
-                            if (tags != nullptr && tags[0] != '\0') {
-                                auto_mem<yajl_val_s> tag_list(yajl_tree_free);
-                                char error_buffer[1024];
-
-                                tag_list = yajl_tree_parse(
-                                    tags, error_buffer, sizeof(error_buffer));
-                                if (!YAJL_IS_ARRAY(tag_list.in())) {
-                                    log_error("invalid tags column: %s", tags);
-                                } else {
-                                    lss.set_user_mark(&textview_curses::BM_META,
-                                                      line_cl);
-                                    for (size_t lpc = 0;
-                                         lpc < tag_list.in()->u.array.len;
-                                         lpc++) {
-                                        yajl_val elem
-                                            = tag_list.in()
-                                                  ->u.array.values[lpc];
-
-                                        if (!YAJL_IS_STRING(elem)) {
-                                            continue;
-                                        }
-                                        bookmark_metadata::KNOWN_TAGS.insert(
-                                            elem->u.string);
-                                        bm_meta[line_cl].add_tag(
-                                            elem->u.string);
-                                    }
-                                }
-                                meta = true;
-                            }
-                            if (!meta) {
-                                marked_session_lines.push_back(line_cl);
-                                lss.set_user_mark(&textview_curses::BM_USER,
-                                                  line_cl);
-                            }
-                            reload_needed = true;
-                        }
-
-                        ++line_iter;
+                    if (tags != nullptr) {
+                        sb.sb_tags = tags;
                     }
+                    marks.emplace_back(std::move(sb));
                     break;
                 }
 
@@ -656,6 +642,110 @@ load_time_bookmarks()
         }
 
         sqlite3_reset(stmt.in());
+
+        std::stable_sort(marks.begin(),
+                         marks.end(),
+                         [](const auto& lhs, const auto& rhs) {
+                             return lhs.sb_log_tv < rhs.sb_log_tv;
+                         });
+    }
+
+    for (file_iter = lnav_data.ld_log_source.begin();
+         file_iter != lnav_data.ld_log_source.end();
+         ++file_iter)
+    {
+        auto lf = (*file_iter)->get_file();
+
+        if (lf == nullptr || lf->size() == 0) {
+            continue;
+        }
+
+        const auto& marks
+            = format_marks[lf->get_format()->get_name().to_string()];
+        auto base_content_line = lss.get_file_base_content_line(file_iter);
+        auto low_line_iter = lf->begin();
+        auto high_line_iter = lf->end();
+
+        --high_line_iter;
+
+        auto low_tv = lf->original_line_time(low_line_iter);
+        auto high_tv = lf->original_line_time(high_line_iter);
+        auto range_start = std::lower_bound(
+            marks.begin(),
+            marks.end(),
+            low_tv,
+            [](const auto& sb, const auto& tv) { return sb.sb_log_tv < tv; });
+        auto range_end = std::upper_bound(
+            range_start,
+            marks.end(),
+            high_tv,
+            [](const auto& tv, const auto& sb) { return tv < sb.sb_log_tv; });
+
+        /*
+         * Prefer the marks from the session being loaded, otherwise use the
+         * marks from the most recent session that covers this file.
+         */
+        int64_t mark_session = -1;
+
+        for (auto iter = range_start; iter != range_end; ++iter) {
+            if (iter->sb_session_time == lnav_data.ld_session_load_time) {
+                mark_session = iter->sb_session_time;
+                break;
+            }
+            mark_session = std::max(mark_session, iter->sb_session_time);
+        }
+
+        auto iter = range_start;
+
+        while (iter != range_end) {
+            std::unordered_map<std::string, const saved_bookmark*> hash_marks;
+            auto log_tv = iter->sb_log_tv;
+
+            for (; iter != range_end && !(log_tv < iter->sb_log_tv); ++iter) {
+                if (iter->sb_session_time != mark_session
+                    || !iter->sb_has_part_name)
+                {
+                    continue;
+                }
+                hash_marks[iter->sb_log_hash] = &(*iter);
+            }
+
+            if (hash_marks.empty()) {
+                continue;
+            }
+
+            auto line_iter = lower_bound(lf->begin(), lf->end(), log_tv);
+            while (line_iter != lf->end()) {
+                struct timeval line_tv = line_iter->get_timeval();
+
+                if (line_tv != log_tv) {
+                    break;
+                }
+
+                auto cl = content_line_t(std::distance(lf->begin(), line_iter));
+                auto read_result = lf->read_line(line_iter);
+
+                if (read_result.isErr()) {
+                    break;
+                }
+
+                auto sbr = read_result.unwrap();
+
+                auto line_hash = hasher()
+                                     .update(sbr.get_data(), sbr.length())
+                                     .update(cl)
+                                     .to_string();
+                auto hash_iter = hash_marks.find(line_hash);
+
+                if (hash_iter != hash_marks.end()) {
+                    restore_user_mark(content_line_t(base_content_line + cl),
+                                      *hash_iter->second);
+                    reload_needed = true;
+                }
+
+                ++line_iter;
+            }
+        }
     }
 
     if (sqlite3_prepare_v2(
@@ -18,6 +18,7 @@
 #include <string.h>
 
 #include "base/humanize.hh"
+#include "base/lrucache.hpp"
 #include "base/lnav.gzip.hh"
 #include "base/string_util.hh"
 #include "column_namer.hh"
@@ -40,49 +41,68 @@
 
 using namespace mapbox;
 
-typedef struct {
-    std::shared_ptr<pcrepp> re2;
-} cache_entry;
-
-static cache_entry*
+static std::shared_ptr<pcrepp>
 find_re(const char* re)
 {
-    using safe_cache = safe::Safe<std::unordered_map<std::string, cache_entry>>;
-    static safe_cache CACHE;
+    using re_cache = cache::lru_cache<std::string, std::shared_ptr<pcrepp>>;
+    using safe_cache = safe::Safe<re_cache>;
+    static const size_t MAX_CACHE_SIZE = 128;
+    static safe_cache CACHE(safe::default_construct_mutex, MAX_CACHE_SIZE);
+    thread_local struct {
+        std::string le_re;
+        std::shared_ptr<pcrepp> le_value;
+    } last_entry;
+
+    /*
+     * The same expression is usually applied to every row in a query, so
+     * check the last one used by this thread before taking the lock.
+     */
+    if (last_entry.le_value != nullptr && last_entry.le_re == re) {
+        return last_entry.le_value;
+    }
 
-    safe::WriteAccess<safe_cache> wcache(CACHE);
     std::string re_str = re;
-    auto iter = wcache->find(re_str);
+    std::shared_ptr<pcrepp> retval;
 
-    if (iter == wcache->end()) {
-        cache_entry c;
+    {
+        safe::WriteAccess<safe_cache> wcache(CACHE);
+        auto cached = wcache->get(re_str);
 
-        c.re2 = std::make_shared<pcrepp>(re_str);
-        auto pair = wcache->insert(std::make_pair(re_str, c));
+        if (cached) {
+            retval = cached.value();
+        }
+    }
+
+    if (retval == nullptr) {
+        retval = std::make_shared<pcrepp>(re_str);
 
-        iter = pair.first;
+        safe::WriteAccess<safe_cache> wcache(CACHE);
+        wcache->put(re_str, retval);
     }
 
-    return &iter->second;
+    last_entry.le_re = re_str;
+    last_entry.le_value = retval;
+
+    return retval;
 }
 
 static bool
 regexp(const char* re, const char* str)
 {
-    cache_entry* reobj = find_re(re);
+    auto reobj = find_re(re);
     pcre_context_static<30> pc;
     pcre_input pi(str);
 
-    return reobj->re2->match(pc, pi);
+    return reobj->match(pc, pi);
 }
 
 static util::variant<int64_t, double, const char*, string_fragment, json_string>
 regexp_match(const char* re, const char* str)
 {
-    cache_entry* reobj = find_re(re);
+    auto reobj = find_re(re);
     pcre_context_static<30> pc;
     pcre_input pi(str);
-    pcrepp& extractor = *reobj->re2;
+    pcrepp& extractor = *reobj;
 
     if (extractor.get_capture_count() == 0) {
         throw pcrepp::error("regular expression does not have any captures");
@@ -255,9 +275,9 @@ logfmt2json(string_fragment line)
 static std::string
 regexp_replace(const char* str, const char* re, const char* repl)
 {
-    cache_entry* reobj = find_re(re);
+    auto reobj = find_re(re);
 
-    return reobj->re2->replace(str, repl);
+    return reobj->replace(str, repl);
 }
 
 static std::string
@@ -33,11 +33,13 @@
 #include "textview_curses.hh"
 
 #include "ansi_scrubber.hh"
+#include "base/perf_stats.hh"
 #include "base/time_util.hh"
 #include "config.h"
 #include "data_parser.hh"
 #include "fmt/format.h"
 #include "lnav_config.hh"
+#include "lnav_util.hh"
 #include "log_format.hh"
 #include "logfile.hh"
 #include "shlex.hh"
@@ -80,6 +82,8 @@ text_filter::add_line(logfile_filter_state& lfs,
                       logfile::const_iterator ll,
                       shared_buffer_ref& line)
 {
+    lnav::perf::add(lnav::perf::counter_t::FILTER_EVALS);
+
     bool match_state = this->matches(*lfs.tfs_logfile, ll, line);
 
     if (ll->is_message()) {
@@ -143,6 +147,7 @@ textview_curses::reload_config(error_reporter& reporter)
 {
     const static auto DEFAULT_THEME_NAME = std::string("default");
 
+    this->tc_highlight_cache.clear();
     for (auto iter = this->tc_highlights.begin();
          iter != this->tc_highlights.end();)
     {
@@ -261,6 +266,7 @@ textview_curses::grep_begin(grep_proc<vis_line_t>& gp,
     this->tc_searching += 1;
     this->tc_search_action(this);
 
+    this->merge_pending_search_hits();
     if (start != -1_vl) {
         auto& search_bv = this->tc_bookmarks[&BM_SEARCH];
         auto pair = search_bv.equal_range(start, stop);
@@ -282,9 +288,21 @@ textview_curses::grep_begin(grep_proc<vis_line_t>& gp,
     listview_curses::reload_data();
 }
 
+void
+textview_curses::merge_pending_search_hits()
+{
+    if (this->tc_pending_search_hits.empty()) {
+        return;
+    }
+
+    this->tc_bookmarks[&BM_SEARCH].merge(this->tc_pending_search_hits);
+    this->tc_pending_search_hits.clear();
+}
+
 void
 textview_curses::grep_end_batch(grep_proc<vis_line_t>& gp)
 {
+    this->merge_pending_search_hits();
     if (this->tc_follow_deadline.tv_sec
         && this->tc_follow_top == this->get_top()) {
         struct timeval now;
@@ -319,7 +337,13 @@ textview_curses::grep_match(grep_proc<vis_line_t>& gp,
                             int start,
                             int end)
 {
-    this->tc_bookmarks[&BM_SEARCH].insert_once(vis_line_t(line));
+    auto& search_bv = this->tc_bookmarks[&BM_SEARCH];
+
+    if (search_bv.empty() || search_bv.back() < line) {
+        search_bv.push_back(line);
+    } else {
+        this->tc_pending_search_hits.insert_once(line);
+    }
     if (this->tc_sub_source != nullptr) {
         this->tc_sub_source->text_mark(&BM_SEARCH, line, true);
     }
@@ -455,34 +479,61 @@ textview_curses::textview_value_for_row(vis_line_t row, attr_line_t& value_out)
         format_name = format_attr_opt.value().get();
     }
 
-    for (auto& tc_highlight : this->tc_highlights) {
-        bool internal_hl
-            = tc_highlight.first.first == highlight_source_t::INTERNAL
-            || tc_highlight.first.first == highlight_source_t::THEME;
-
-        if (!tc_highlight.second.h_text_formats.empty()
-            && tc_highlight.second.h_text_formats.count(source_format) == 0)
-        {
-            continue;
+    // Running every highlighter over the line is the most expensive part
+    // of rendering, so reuse the result from the last time this line was
+    // drawn.  Non-nestable highlights check for existing styles, so those
+    // are part of the key too.
+    hasher h;
+
+    h.update(str)
+        .update((int) source_format)
+        .update((uintptr_t) format_name.get())
+        .update(body.lr_start)
+        .update(orig_line.lr_start);
+    for (const auto& attr : sa) {
+        if (attr.sa_type == &view_curses::VC_STYLE) {
+            h.update(attr.sa_range.lr_start).update(attr.sa_range.lr_end);
         }
+    }
 
-        if (!tc_highlight.second.h_format_name.empty()
-            && tc_highlight.second.h_format_name != format_name)
-        {
-            continue;
-        }
+    auto hl_key = h.to_string();
+    auto cached_attrs = this->tc_highlight_cache.get(hl_key);
+    if (cached_attrs) {
+        sa.insert(sa.end(), cached_attrs->begin(), cached_attrs->end());
+    } else {
+        auto pre_highlight_size = sa.size();
+        for (auto& tc_highlight : this->tc_highlights) {
+            bool internal_hl
+                = tc_highlight.first.first == highlight_source_t::INTERNAL
+                || tc_highlight.first.first == highlight_source_t::THEME;
+
+            if (!tc_highlight.second.h_text_formats.empty()
+                && tc_highlight.second.h_text_formats.count(source_format) == 0)
+            {
+                continue;
+            }
 
-        if (this->tc_disabled_highlights.count(tc_highlight.first.first)) {
-            continue;
-        }
+            if (!tc_highlight.second.h_format_name.empty()
+                && tc_highlight.second.h_format_name != format_name)
+            {
+                continue;
+            }
 
-        // Internal highlights should only apply to the log message body so
-        // that we don't start highlighting other fields.  User-provided
-        // highlights should apply only to the line itself and not any of the
-        // surrounding decorations that are added (for example, the file lines
-        // that are inserted at the beginning of the log view).
-        int start_pos = internal_hl ? body.lr_start : orig_line.lr_start;
-        tc_highlight.second.annotate(value_out, start_pos);
+            if (this->tc_disabled_highlights.count(tc_highlight.first.first)) {
+                continue;
+            }
+
+            // Internal highlights should only apply to the log message body
+            // so that we don't start highlighting other fields.
+            // User-provided highlights should apply only to the line itself
+            // and not any of the surrounding decorations that are added (for
+            // example, the file lines that are inserted at the beginning of
+            // the log view).
+            int start_pos = internal_hl ? body.lr_start : orig_line.lr_start;
+            tc_highlight.second.annotate(value_out, start_pos);
+        }
+        this->tc_highlight_cache.put(
+            hl_key, string_attrs_t(sa.begin() + pre_highlight_size, sa.end()));
     }
 
     if (this->tc_hide_fields) {
@@ -37,6 +37,7 @@
 
 #include "base/func_util.hh"
 #include "base/lnav_log.hh"
+#include "base/lrucache.hpp"
 #include "bookmarks.hh"
 #include "grep_proc.hh"
 #include "highlighter.hh"
@@ -778,6 +779,7 @@ public:
     };
 
     void grep_end_batch(grep_proc<vis_line_t>& gp);
+    void merge_pending_search_hits();
     void grep_end(grep_proc<vis_line_t>& gp);
 
     size_t listview_rows(const listview_curses& lv)
@@ -859,6 +861,7 @@ public:
 
     void match_reset()
     {
+        this->tc_pending_search_hits.clear();
         this->tc_bookmarks[&BM_SEARCH].clear();
         if (this->tc_sub_source != nullptr) {
             this->tc_sub_source->text_clear_marks(&BM_SEARCH);
@@ -867,6 +870,9 @@ public:
 
     highlight_map_t& get_highlights()
     {
+        // The caller might change the highlights, so the cached results
+        // cannot be trusted anymore.
+        this->tc_highlight_cache.clear();
         return this->tc_highlights;
     };
 
@@ -877,6 +883,7 @@ public:
 
     std::set<highlight_source_t>& get_disabled_highlights()
     {
+        this->tc_highlight_cache.clear();
         return this->tc_disabled_highlights;
     }
 
@@ -1023,6 +1030,12 @@ protected:
     std::shared_ptr<text_delegate> tc_delegate;
 
     vis_bookmarks tc_bookmarks;
+    /**
+     * Search hits that came in before the last hit in BM_SEARCH, like when
+     * a search wraps around to the top.  They are merged in at the end of
+     * each batch instead of being inserted one at a time.
+     */
+    bookmark_vector<vis_line_t> tc_pending_search_hits;
 
     int tc_searching{0};
     struct timeval tc_follow_deadline {
@@ -1034,6 +1047,11 @@ protected:
 
     highlight_map_t tc_highlights;
     std::set<highlight_source_t> tc_disabled_highlights;
+    /**
+     * The attributes added by the highlighters to recently rendered lines,
+     * keyed by a hash of the line and anything else that affects them.
+     */
+    cache::lru_cache<std::string, string_attrs_t> tc_highlight_cache{512};
 
     vis_line_t tc_selection_start{-1_vl};
     vis_line_t tc_selection_last{-1_vl};
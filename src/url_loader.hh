@@ -33,15 +33,20 @@
 #include "config.h"
 
 #ifdef HAVE_LIBCURL
+#    include <algorithm>
+
 #    include <curl/curl.h>
 #    include <paths.h>
+#    include <strings.h>
 
 #    include "base/fs_util.hh"
 #    include "curl_looper.hh"
 
 class url_loader : public curl_request {
 public:
-    url_loader(const std::string& url) : curl_request(url), ul_resume_offset(0)
+    url_loader(const std::string& url)
+        : curl_request(url), ul_resume_offset(0),
+          ul_header_list(curl_slist_free_all)
     {
         auto tmp_res = lnav::filesystem::open_temp_file(
             ghc::filesystem::temp_directory_path() / "lnav.url.XXXXXX");
@@ -56,6 +61,8 @@ public:
         curl_easy_setopt(this->cr_handle, CURLOPT_URL, this->cr_name.c_str());
         curl_easy_setopt(this->cr_handle, CURLOPT_WRITEFUNCTION, write_cb);
         curl_easy_setopt(this->cr_handle, CURLOPT_WRITEDATA, this);
+        curl_easy_setopt(this->cr_handle, CURLOPT_HEADERFUNCTION, header_cb);
+        curl_easy_setopt(this->cr_handle, CURLOPT_HEADERDATA, this);
         curl_easy_setopt(this->cr_handle, CURLOPT_FILETIME, 1);
     };
 
@@ -73,6 +80,9 @@ public:
     {
         curl_request::complete(result);
 
+        this->ul_skip_bytes = 0;
+        this->ul_checked_response = false;
+
         switch (result) {
             case CURLE_OK:
                 break;
@@ -89,6 +99,14 @@ public:
                 return -1;
         }
 
+        long response_code = 0;
+
+        curl_easy_getinfo(
+            this->cr_handle, CURLINFO_RESPONSE_CODE, &response_code);
+        if (response_code != 304) {
+            this->ul_etag = this->ul_reply_etag;
+        }
+
         long file_time;
         CURLcode rc;
 
@@ -96,6 +114,13 @@ public:
         if (rc == CURLE_OK) {
             time_t current_time;
 
+            // A "304 Not Modified" reply does not carry the time again.
+            if (file_time == -1) {
+                file_time = this->ul_last_modified;
+            } else {
+                this->ul_last_modified = file_time;
+            }
+
             time(&current_time);
             if (file_time == -1
                 || (current_time - file_time) < FOLLOW_IF_MODIFIED_SINCE) {
@@ -111,8 +136,25 @@ public:
                     start = 0;
                     this->ul_resume_offset = 0;
                 }
+                this->ul_range_start = start;
                 snprintf(range, sizeof(range), "%ld-", (long) start);
                 curl_easy_setopt(this->cr_handle, CURLOPT_RANGE, range);
+                // Let the server skip the transfer if nothing changed.  The
+                // Last-Modified time only has a resolution of one second,
+                // so lines appended in the same second as the last fetch
+                // would be missed by If-Modified-Since.  The ETag changes
+                // along with the content.
+                if (this->ul_etag.empty()) {
+                    this->ul_header_list = nullptr;
+                } else {
+                    auto inm = "If-None-Match: " + this->ul_etag;
+
+                    this->ul_header_list
+                        = curl_slist_append(nullptr, inm.c_str());
+                }
+                curl_easy_setopt(this->cr_handle,
+                                 CURLOPT_HTTPHEADER,
+                                 this->ul_header_list.in());
                 return 2000;
             } else {
                 log_debug("URL was not recently modified, not tailing: %s",
@@ -137,18 +179,70 @@ private:
     {
         url_loader* ul = (url_loader*) userp;
         char* c_contents = (char*) contents;
+        size_t total = size * nmemb;
         ssize_t retval;
 
-        c_contents += ul->ul_resume_offset;
-        retval = write(
-            ul->ul_fd, c_contents, (size * nmemb) - ul->ul_resume_offset);
-        retval += ul->ul_resume_offset;
-        ul->ul_resume_offset = 0;
-        return retval;
+        if (!ul->ul_checked_response) {
+            long response_code = 0;
+
+            ul->ul_checked_response = true;
+            ul->ul_skip_bytes = ul->ul_resume_offset;
+            curl_easy_getinfo(
+                ul->cr_handle, CURLINFO_RESPONSE_CODE, &response_code);
+            if (response_code == 200) {
+                // The server ignored the range and is sending the whole
+                // file, skip the part that we already have.
+                ul->ul_skip_bytes += ul->ul_range_start;
+            }
+            ul->ul_resume_offset = 0;
+        }
+
+        size_t skip = std::min((size_t) ul->ul_skip_bytes, total);
+
+        ul->ul_skip_bytes -= skip;
+        if (skip == total) {
+            return total;
+        }
+        retval = write(ul->ul_fd, c_contents + skip, total - skip);
+        if (retval < 0) {
+            return retval;
+        }
+        return retval + skip;
+    }
+
+    static size_t header_cb(char* buffer,
+                            size_t size,
+                            size_t nitems,
+                            void* userp)
+    {
+        url_loader* ul = (url_loader*) userp;
+        size_t total = size * nitems;
+        std::string line(buffer, total);
+
+        if (line.compare(0, 5, "HTTP/") == 0) {
+            // The headers for a new response, like after a redirect.
+            ul->ul_reply_etag.clear();
+        } else if (strncasecmp(line.c_str(), "etag:", 5) == 0) {
+            auto start = line.find_first_not_of(" \t", 5);
+            auto end = line.find_last_not_of(" \t\r\n");
+
+            if (start != std::string::npos && end >= start) {
+                ul->ul_reply_etag = line.substr(start, end - start + 1);
+            }
+        }
+
+        return total;
     }
 
     auto_fd ul_fd;
     off_t ul_resume_offset;
+    off_t ul_range_start{0};
+    off_t ul_skip_bytes{0};
+    bool ul_checked_response{false};
+    long ul_last_modified{-1};
+    std::string ul_etag;
+    std::string ul_reply_etag;
+    auto_mem<struct curl_slist> ul_header_list;
 };
 #endif
 
@@ -30,9 +30,11 @@
 #include "view_helpers.hh"
 
 #include "config.h"
+#include "base/lrucache.hpp"
 #include "environ_vtab.hh"
 #include "help-txt.h"
 #include "lnav.hh"
+#include "lnav_util.hh"
 #include "pretty_printer.hh"
 #include "shlex.hh"
 #include "sql_help.hh"
@@ -98,6 +100,85 @@ open_schema_view()
     schema_tc->redo_search();
 }
 
+/**
+ * Pretty-printing a large message is expensive and the pretty view is
+ * rebuilt every time it is opened, so the output for recently displayed
+ * messages is kept around.  The key is a hash of the rendered message,
+ * which changes along with the content or any of the render flags.
+ */
+static cache::lru_cache<std::string, attr_line_t>&
+pretty_cache()
+{
+    static const size_t MAX_CACHED_MESSAGES = 256;
+    static cache::lru_cache<std::string, attr_line_t> retval(
+        MAX_CACHED_MESSAGES);
+
+    return retval;
+}
+
+static attr_line_t
+pretty_print_log_message(const attr_line_t& al)
+{
+    auto key = hasher().update("log").update(al.get_string()).to_string();
+    auto cached = pretty_cache().get(key);
+
+    if (cached) {
+        return cached.value();
+    }
+
+    line_range orig_lr
+        = find_string_attr_range(al.get_attrs(), &SA_ORIGINAL_LINE);
+    attr_line_t orig_al = al.subline(orig_lr.lr_start, orig_lr.length());
+    attr_line_t prefix_al = al.subline(0, orig_lr.lr_start);
+
+    data_scanner ds(orig_al.get_string());
+    pretty_printer pp(&ds, orig_al.get_attrs());
+    attr_line_t pretty_al;
+    std::vector<attr_line_t> pretty_lines;
+    attr_line_t retval;
+
+    // TODO: dump more details of the line in the output.
+    pp.append_to(pretty_al);
+    pretty_al.split_lines(pretty_lines);
+
+    for (auto& pretty_line : pretty_lines) {
+        if (pretty_line.empty() && &pretty_line == &pretty_lines.back()) {
+            break;
+        }
+        pretty_line.insert(0, prefix_al);
+        pretty_line.append("\n");
+        retval.append(pretty_line);
+    }
+
+    pretty_cache().put(key, retval);
+
+    return retval;
+}
+
+static attr_line_t
+pretty_print_text_message(shared_buffer_ref& sbr)
+{
+    auto key = hasher()
+                   .update("text")
+                   .update(sbr.get_data(), sbr.length())
+                   .to_string();
+    auto cached = pretty_cache().get(key);
+
+    if (cached) {
+        return cached.value();
+    }
+
+    data_scanner ds(sbr);
+    string_attrs_t sa;
+    pretty_printer pp(&ds, sa);
+    attr_line_t retval;
+
+    pp.append_to(retval);
+    pretty_cache().put(key, retval);
+
+    return retval;
+}
+
 static void
 open_pretty_view()
 {
@@ -125,7 +206,6 @@ open_pretty_view()
             content_line_t cl = lss.at(vl);
             auto lf = lss.find(cl);
             auto ll = lf->begin() + cl;
-            shared_buffer_ref sbr;
 
             if (!first_line && !ll->is_message()) {
                 continue;
@@ -144,30 +224,7 @@ open_pretty_view()
                 al.apply_hide();
             }
 
-            line_range orig_lr
-                = find_string_attr_range(al.get_attrs(), &SA_ORIGINAL_LINE);
-            attr_line_t orig_al
-                = al.subline(orig_lr.lr_start, orig_lr.length());
-            attr_line_t prefix_al = al.subline(0, orig_lr.lr_start);
-
-            data_scanner ds(orig_al.get_string());
-            pretty_printer pp(&ds, orig_al.get_attrs());
-            attr_line_t pretty_al;
-            std::vector<attr_line_t> pretty_lines;
-
-            // TODO: dump more details of the line in the output.
-            pp.append_to(pretty_al);
-            pretty_al.split_lines(pretty_lines);
-
-            for (auto& pretty_line : pretty_lines) {
-                if (pretty_line.empty() && &pretty_line == &pretty_lines.back())
-                {
-                    break;
-                }
-                pretty_line.insert(0, prefix_al);
-                pretty_line.append("\n");
-                full_text.append(pretty_line);
-            }
+            full_text.append(pretty_print_log_message(al));
 
             first_line = false;
         }
@@ -184,11 +241,7 @@ open_pretty_view()
             shared_buffer_ref sbr;
 
             lf->read_full_message(ll, sbr);
-            data_scanner ds(sbr);
-            string_attrs_t sa;
-            pretty_printer pp(&ds, sa);
-
-            pp.append_to(full_text);
+            full_text.append(pretty_print_text_message(sbr));
         }
     }
     auto* pts = new plain_text_source();
@@ -0,0 +1,597 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "base/auto_fd.hh"
+#include "base/date_time_scanner.hh"
+#include "base/injector.hh"
+#include "config.h"
+#include "data_parser.hh"
+#include "data_scanner.hh"
+#include "line_buffer.hh"
+#include "log_format.hh"
+#include "log_format_loader.hh"
+#include "logfile.hh"
+
+/**
+ * Throughput benchmarks for the indexing hot paths.  Synthetic logs are
+ * generated deterministically so that the numbers can be compared between
+ * versions.  Each stage prints one JSON object per line to stdout.
+ */
+
+struct bench_log {
+    const char* bl_name;
+    std::function<std::string(size_t)> bl_generator;
+    /** Returns the offset of the timestamp in a line or npos if none. */
+    std::function<size_t(const std::string&)> bl_timestamp_offset;
+};
+
+struct bench_result {
+    size_t br_lines{0};
+    size_t br_bytes{0};
+};
+
+/** A small LCG so that the output does not depend on the libc. */
+static uint32_t
+next_rand(uint32_t& state)
+{
+    state = state * 1103515245U + 12345U;
+    return (state >> 16) & 0x7fff;
+}
+
+static const char* LEVELS[] = {
+    "INFO",
+    "INFO",
+    "INFO",
+    "WARN",
+    "ERROR",
+    "DEBUG",
+};
+
+static const char* MONTHS[] = {
+    "Jan",
+    "Feb",
+    "Mar",
+    "Apr",
+    "May",
+    "Jun",
+    "Jul",
+    "Aug",
+    "Sep",
+    "Oct",
+    "Nov",
+    "Dec",
+};
+
+static std::string
+gen_syslog(size_t line_count)
+{
+    std::string retval;
+    uint32_t state = 1;
+    time_t now = 1194107018;
+    char line[1024];
+
+    for (size_t lpc = 0; lpc < line_count; lpc++) {
+        struct tm tm;
+
+        now += next_rand(state) % 3;
+        gmtime_r(&now, &tm);
+        snprintf(line,
+                 sizeof(line),
+                 "%s %2d %02d:%02d:%02d veridian sshd[%u]: Accepted publickey "
+                 "for user%u from 10.0.%u.%u port %u ssh2\n",
+                 MONTHS[tm.tm_mon],
+                 tm.tm_mday,
+                 tm.tm_hour,
+                 tm.tm_min,
+                 tm.tm_sec,
+                 1000 + next_rand(state) % 30000,
+                 next_rand(state) % 100,
+                 next_rand(state) % 256,
+                 next_rand(state) % 256,
+                 1024 + next_rand(state) % 30000);
+        retval.append(line);
+    }
+
+    return retval;
+}
+
+static std::string
+gen_access_log(size_t line_count)
+{
+    static const char* METHODS[] = {"GET", "GET", "POST", "PUT", "DELETE"};
+    static const int STATUSES[] = {200, 200, 200, 304, 404, 500};
+
+    std::string retval;
+    uint32_t state = 2;
+    time_t now = 1194107018;
+    char line[1024];
+
+    for (size_t lpc = 0; lpc < line_count; lpc++) {
+        struct tm tm;
+
+        now += next_rand(state) % 3;
+        gmtime_r(&now, &tm);
+        snprintf(line,
+                 sizeof(line),
+                 "192.168.%u.%u - - [%02d/%s/%d:%02d:%02d:%02d +0000] "
+                 "\"%s /api/v1/items/%u?page=%u HTTP/1.1\" %d %u \"-\" "
+                 "\"Mozilla/5.0 (X11; Linux x86_64)\"\n",
+                 next_rand(state) % 256,
+                 next_rand(state) % 256,
+                 tm.tm_mday,
+                 MONTHS[tm.tm_mon],
+                 tm.tm_year + 1900,
+                 tm.tm_hour,
+                 tm.tm_min,
+                 tm.tm_sec,
+                 METHODS[next_rand(state) % 5],
+                 next_rand(state),
+                 next_rand(state) % 10,
+                 STATUSES[next_rand(state) % 6],
+                 next_rand(state) * 4);
+        retval.append(line);
+    }
+
+    return retval;
+}
+
+static std::string
+gen_json_log(size_t line_count)
+{
+    std::string retval;
+    uint32_t state = 3;
+    time_t now = 1194107018;
+    char line[1024];
+
+    for (size_t lpc = 0; lpc < line_count; lpc++) {
+        struct tm tm;
+
+        now += next_rand(state) % 3;
+        gmtime_r(&now, &tm);
+        snprintf(line,
+                 sizeof(line),
+                 "{\"@timestamp\": \"%d-%02d-%02dT%02d:%02d:%02d.%03uZ\", "
+                 "\"level\": \"%s\", \"logger\": \"com.example.Service%u\", "
+                 "\"message\": \"request %u finished in %u ms\", "
+                 "\"user\": {\"id\": %u, \"name\": \"user%u\"}}\n",
+                 tm.tm_year + 1900,
+                 tm.tm_mon + 1,
+                 tm.tm_mday,
+                 tm.tm_hour,
+                 tm.tm_min,
+                 tm.tm_sec,
+                 next_rand(state) % 1000,
+                 LEVELS[next_rand(state) % 6],
+                 next_rand(state) % 10,
+                 next_rand(state),
+                 next_rand(state) % 5000,
+                 next_rand(state),
+                 next_rand(state) % 100);
+        retval.append(line);
+    }
+
+    return retval;
+}
+
+static std::string
+gen_java_log(size_t line_count)
+{
+    std::string retval;
+    uint32_t state = 4;
+    time_t now = 1194107018;
+    char line[1024];
+    size_t lpc = 0;
+
+    while (lpc < line_count) {
+        struct tm tm;
+        const char* level = LEVELS[next_rand(state) % 6];
+
+        now += next_rand(state) % 3;
+        gmtime_r(&now, &tm);
+        snprintf(line,
+                 sizeof(line),
+                 "%d-%02d-%02d %02d:%02d:%02d,%03u %s [worker-%u] "
+                 "com.example.Handler - processing request %u\n",
+                 tm.tm_year + 1900,
+                 tm.tm_mon + 1,
+                 tm.tm_mday,
+                 tm.tm_hour,
+                 tm.tm_min,
+                 tm.tm_sec,
+                 next_rand(state) % 1000,
+                 level,
+                 next_rand(state) % 16,
+                 next_rand(state));
+        retval.append(line);
+        lpc += 1;
+        if (strcmp(level, "ERROR") == 0) {
+            retval.append(
+                "java.lang.IllegalStateException: request failed\n");
+            lpc += 1;
+            for (int frame = 0; frame < 8 && lpc < line_count; frame++) {
+                snprintf(line,
+                         sizeof(line),
+                         "\tat com.example.Handler.step%d(Handler.java:%u)\n",
+                         frame,
+                         next_rand(state) % 500);
+                retval.append(line);
+                lpc += 1;
+            }
+        }
+    }
+
+    return retval;
+}
+
+static size_t
+timestamp_at_start(const std::string& line)
+{
+    if (line.empty() || !isalnum((unsigned char) line[0])) {
+        return std::string::npos;
+    }
+
+    return 0;
+}
+
+static size_t
+access_log_timestamp(const std::string& line)
+{
+    auto retval = line.find('[');
+
+    return retval == std::string::npos ? retval : retval + 1;
+}
+
+static size_t
+json_timestamp(const std::string& line)
+{
+    static const std::string KEY = "\"@timestamp\": \"";
+
+    auto retval = line.find(KEY);
+
+    return retval == std::string::npos ? retval : retval + KEY.size();
+}
+
+static size_t
+java_timestamp(const std::string& line)
+{
+    // Skip the exception and stack trace lines.
+    if (line.empty() || !isdigit((unsigned char) line[0])) {
+        return std::string::npos;
+    }
+
+    return 0;
+}
+
+/**
+ * @return The peak RSS of the whole process so far, which includes the
+ * generated logs and every earlier stage, not just the current stage.
+ */
+static long
+process_max_rss_kb()
+{
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+#ifdef __APPLE__
+    return ru.ru_maxrss / 1024;
+#else
+    return ru.ru_maxrss;
+#endif
+}
+
+static void
+report(const char* stage,
+       const char* log_name,
+       const bench_result& br,
+       std::chrono::steady_clock::duration elapsed)
+{
+    double secs = std::chrono::duration<double>(elapsed).count();
+
+    if (secs <= 0.0) {
+        secs = 1e-9;
+    }
+    printf(
+        "{\"stage\": \"%s\", \"log\": \"%s\", \"lines\": %zu, \"bytes\": %zu, "
+        "\"seconds\": %.6f, \"lines_per_sec\": %.0f, \"bytes_per_sec\": %.0f, "
+        "\"process_max_rss_kb\": %ld}\n",
+        stage,
+        log_name,
+        br.br_lines,
+        br.br_bytes,
+        secs,
+        br.br_lines / secs,
+        br.br_bytes / secs,
+        process_max_rss_kb());
+    fflush(stdout);
+}
+
+static bench_result
+bench_line_buffer(const std::string& path)
+{
+    bench_result retval;
+    auto_fd fd(open(path.c_str(), O_RDONLY));
+    line_buffer lb;
+    file_range last_range;
+
+    lb.set_fd(fd);
+    while (true) {
+        auto load_result = lb.load_next_line(last_range);
+
+        if (load_result.isErr()) {
+            break;
+        }
+
+        auto li = load_result.unwrap();
+
+        if (li.li_file_range.empty()) {
+            break;
+        }
+
+        auto read_result = lb.read_range(li.li_file_range);
+
+        if (read_result.isErr()) {
+            break;
+        }
+        retval.br_lines += 1;
+        retval.br_bytes += li.li_file_range.fr_size;
+        last_range = li.li_file_range;
+    }
+
+    return retval;
+}
+
+static bench_result
+bench_logfile(const std::string& path)
+{
+    bench_result retval;
+    logfile_open_options default_loo;
+    auto open_res = logfile::open(path, default_loo);
+
+    if (open_res.isErr()) {
+        fprintf(stderr,
+                "error: unable to open logfile: %s\n",
+                open_res.unwrapErr().c_str());
+        return retval;
+    }
+
+    auto lf = open_res.unwrap();
+
+    while (lf->rebuild_index() != logfile::rebuild_result_t::NO_NEW_LINES) {
+    }
+    retval.br_lines = lf->size();
+    retval.br_bytes = lf->get_index_size();
+
+    return retval;
+}
+
+static std::vector<std::string>
+split_lines(const std::string& content)
+{
+    std::vector<std::string> retval;
+    size_t start = 0;
+
+    while (start < content.size()) {
+        auto end = content.find('\n', start);
+
+        if (end == std::string::npos) {
+            end = content.size();
+        }
+        retval.emplace_back(content.substr(start, end - start));
+        start = end + 1;
+    }
+
+    return retval;
+}
+
+static bench_result
+bench_date_time_scanner(const bench_log& bl,
+                        const std::vector<std::string>& lines)
+{
+    bench_result retval;
+    date_time_scanner dts;
+    size_t failed = 0;
+
+    for (const auto& line : lines) {
+        struct exttm tm;
+        struct timeval tv;
+        auto start = bl.bl_timestamp_offset(line);
+
+        if (start == std::string::npos) {
+            continue;
+        }
+        auto* end = dts.scan(
+            line.c_str() + start, line.size() - start, nullptr, &tm, tv);
+
+        if (end == nullptr) {
+            failed += 1;
+            continue;
+        }
+        retval.br_lines += 1;
+        retval.br_bytes += line.size();
+    }
+
+    if (failed > 0) {
+        fprintf(stderr,
+                "warning: %s: unable to scan %zu timestamps\n",
+                bl.bl_name,
+                failed);
+    }
+
+    return retval;
+}
+
+static bench_result
+bench_data_parser(const std::vector<std::string>& lines)
+{
+    bench_result retval;
+
+    for (const auto& line : lines) {
+        data_scanner ds(line);
+        data_parser dp(&ds);
+
+        dp.parse();
+        retval.br_lines += 1;
+        retval.br_bytes += line.size();
+    }
+
+    return retval;
+}
+
+int
+main(int argc, char* argv[])
+{
+    int c, retval = EXIT_SUCCESS;
+    size_t line_count = 100000;
+    std::string only_stage;
+
+    while ((c = getopt(argc, argv, "n:s:")) != -1) {
+        switch (c) {
+            case 'n':
+                if (sscanf(optarg, "%zu", &line_count) != 1) {
+                    fprintf(stderr,
+                            "error: line count is not an integer -- %s\n",
+                            optarg);
+                    retval = EXIT_FAILURE;
+                }
+                break;
+            case 's':
+                only_stage = optarg;
+                break;
+            default:
+                retval = EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if (retval != EXIT_SUCCESS) {
+        fprintf(stderr, "usage: %s [-n lines] [-s stage]\n", argv[0]);
+        return retval;
+    }
+
+    {
+        static auto builtin_formats
+            = injector::get<std::vector<std::shared_ptr<log_format>>>();
+        auto& root_formats = log_format::get_root_formats();
+
+        log_format::get_root_formats().insert(root_formats.begin(),
+                                              builtin_formats.begin(),
+                                              builtin_formats.end());
+        builtin_formats.clear();
+    }
+
+    {
+        std::vector<ghc::filesystem::path> paths;
+        std::vector<std::string> errors;
+
+        load_formats(paths, errors);
+    }
+
+    const std::vector<bench_log> LOGS = {
+        {"syslog", gen_syslog, timestamp_at_start},
+        {"access_log", gen_access_log, access_log_timestamp},
+        {"json", gen_json_log, json_timestamp},
+        {"java", gen_java_log, java_timestamp},
+    };
+
+    auto want_stage = [&only_stage](const char* stage) {
+        return only_stage.empty() || only_stage == stage;
+    };
+
+    for (const auto& bl : LOGS) {
+        auto content = bl.bl_generator(line_count);
+        auto path = std::string("bench-") + bl.bl_name + ".log";
+        auto lines = split_lines(content);
+
+        {
+            auto_fd fd(open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+
+            if (fd == -1
+                || write(fd, content.data(), content.size())
+                    != (ssize_t) content.size())
+            {
+                perror("write");
+                return EXIT_FAILURE;
+            }
+        }
+
+        if (want_stage("line_buffer")) {
+            auto start = std::chrono::steady_clock::now();
+            auto br = bench_line_buffer(path);
+
+            report("line_buffer",
+                   bl.bl_name,
+                   br,
+                   std::chrono::steady_clock::now() - start);
+        }
+        if (want_stage("logfile_index")) {
+            auto start = std::chrono::steady_clock::now();
+            auto br = bench_logfile(path);
+
+            report("logfile_index",
+                   bl.bl_name,
+                   br,
+                   std::chrono::steady_clock::now() - start);
+        }
+        if (want_stage("date_time_scanner")) {
+            auto start = std::chrono::steady_clock::now();
+            auto br = bench_date_time_scanner(bl, lines);
+
+            report("date_time_scanner",
+                   bl.bl_name,
+                   br,
+                   std::chrono::steady_clock::now() - start);
+        }
+        if (want_stage("data_parser")) {
+            auto start = std::chrono::steady_clock::now();
+            auto br = bench_data_parser(lines);
+
+            report("data_parser",
+                   bl.bl_name,
+                   br,
+                   std::chrono::steady_clock::now() - start);
+        }
+
+        unlink(path.c_str());
+    }
+
+    return retval;
+}
@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "url_loader.hh"
+
+/**
+ * Fetch a URL with url_loader the given number of times, the way the
+ * curl_looper polls it, and then write out the file that was built up.
+ */
+int
+main(int argc, char* argv[])
+{
+    int c, retval = EXIT_SUCCESS;
+    int poll_count = 1;
+
+    while ((c = getopt(argc, argv, "p:")) != -1) {
+        switch (c) {
+            case 'p':
+                if (sscanf(optarg, "%d", &poll_count) != 1) {
+                    fprintf(stderr,
+                            "error: poll count is not an integer -- %s\n",
+                            optarg);
+                    retval = EXIT_FAILURE;
+                }
+                break;
+            default:
+                retval = EXIT_FAILURE;
+                break;
+        }
+    }
+
+    argc -= optind;
+    argv += optind;
+
+    if (retval != EXIT_SUCCESS || argc != 1) {
+        fprintf(stderr, "usage: drive_url_loader [-p polls] <url>\n");
+        return EXIT_FAILURE;
+    }
+
+#ifndef HAVE_LIBCURL
+    fprintf(stderr, "error: curl support is not enabled\n");
+    retval = EXIT_FAILURE;
+#else
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    {
+        url_loader ul(argv[0]);
+
+        for (int lpc = 0; lpc < poll_count; lpc++) {
+            auto rc = curl_easy_perform(ul.get_handle());
+
+            if (ul.complete(rc) == -1 && lpc + 1 < poll_count) {
+                fprintf(stderr, "error: URL is no longer being polled\n");
+                retval = EXIT_FAILURE;
+                break;
+            }
+        }
+
+        char buffer[4096];
+        off_t offset = 0;
+        ssize_t rc;
+
+        while ((rc = pread(ul.get_fd(), buffer, sizeof(buffer), offset)) > 0) {
+            fwrite(buffer, 1, rc, stdout);
+            offset += rc;
+        }
+    }
+    curl_global_cleanup();
+#endif
+
+    return retval;
+}
@@ -0,0 +1,123 @@
+#! /usr/bin/env python3
+
+"""
+HTTP server used by test_url_loader.sh to check how url_loader polls a URL.
+
+  /static.log  - never changes, so conditional polls get a 304.
+  /grow.log    - grows by a line every request and honors Range headers.
+  /norange.log - grows like grow.log but ignores Range and sends everything.
+  /samesec.log - grows like grow.log but keeps the same Last-Modified time.
+
+Usage: http_fixture.py <port-file> <request-log>
+
+The port the server is listening on is written to <port-file> once it is
+ready.  Every request is appended to <request-log> as the path, whether a
+range, If-Modified-Since, or If-None-Match header was sent, and the response
+status.
+"""
+
+import email.utils
+import hashlib
+import http.server
+import os
+import sys
+import time
+
+START_TIME = int(time.time())
+
+
+def grow_body(count):
+    return "".join("line %d\n" % lpc for lpc in range(count + 2)).encode()
+
+
+class FixtureHandler(http.server.BaseHTTPRequestHandler):
+    request_counts = {}
+
+    def log_message(self, format, *args):
+        pass
+
+    def record(self, status):
+        with open(sys.argv[2], "a") as log:
+            log.write("%s range=%s ims=%s inm=%s %d\n" % (
+                self.path,
+                "yes" if "Range" in self.headers else "no",
+                "yes" if "If-Modified-Since" in self.headers else "no",
+                "yes" if "If-None-Match" in self.headers else "no",
+                status))
+
+    def do_GET(self):
+        count = self.request_counts.get(self.path, 0)
+        self.request_counts[self.path] = count + 1
+
+        if self.path == "/static.log":
+            body = b"static line 0\nstatic line 1\n"
+            mtime = START_TIME
+            honor_range = True
+        elif self.path == "/grow.log":
+            body = grow_body(count)
+            mtime = START_TIME + count
+            honor_range = True
+        elif self.path == "/norange.log":
+            body = grow_body(count)
+            mtime = START_TIME + count
+            honor_range = False
+        elif self.path == "/samesec.log":
+            body = grow_body(count)
+            mtime = START_TIME
+            honor_range = True
+        else:
+            self.record(404)
+            self.send_error(404)
+            return
+
+        etag = '"%s"' % hashlib.sha1(body).hexdigest()
+        inm = self.headers.get("If-None-Match")
+        ims = self.headers.get("If-Modified-Since")
+        if inm is not None:
+            not_modified = inm == etag
+        elif ims is not None:
+            ims_time = email.utils.parsedate_to_datetime(ims).timestamp()
+            not_modified = mtime <= ims_time
+        else:
+            not_modified = False
+        if not_modified:
+            self.record(304)
+            self.send_response(304)
+            self.send_header("ETag", etag)
+            self.end_headers()
+            return
+
+        start = 0
+        range_header = self.headers.get("Range")
+        if honor_range and range_header is not None:
+            start = int(range_header.split("=")[1].split("-")[0])
+
+        if start > 0:
+            self.record(206)
+            self.send_response(206)
+            self.send_header("Content-Range", "bytes %d-%d/%d" % (
+                start, len(body) - 1, len(body)))
+        else:
+            self.record(200)
+            self.send_response(200)
+        self.send_header("Content-Length", str(len(body) - start))
+        self.send_header("Last-Modified",
+                         email.utils.formatdate(mtime, usegmt=True))
+        self.send_header("ETag", etag)
+        self.end_headers()
+        self.wfile.write(body[start:])
+
+
+def main():
+    server = http.server.HTTPServer(("127.0.0.1", 0), FixtureHandler)
+
+    tmp_path = sys.argv[1] + ".tmp"
+    with open(tmp_path, "w") as port_file:
+        port_file.write("%d\n" % server.server_address[1])
+    os.rename(tmp_path, sys.argv[1])
+
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
@@ -51,6 +51,21 @@ main(int argc, char* argv[])
     assert(bv[1] == 3);
     assert(bv[2] == 4);
 
+    {
+        bookmark_vector<vis_line_t> other;
+
+        other.insert_once(vis_line_t(1));
+        other.insert_once(vis_line_t(3));
+        other.insert_once(vis_line_t(5));
+
+        bookmark_vector<vis_line_t> merged = bv;
+        merged.merge(other);
+        assert(merged.size() == 5);
+        for (lpc = 0; lpc < 5; lpc++) {
+            assert(merged[lpc] == lpc + 1);
+        }
+    }
+
     {
         auto range = bv.equal_range(0_vl, 5_vl);
 
@@ -370,6 +370,51 @@ check_output "adjust-log-time is not working" <<EOF
 EOF
 
 
+cat > logfile_splice.1 <<EOF
+192.168.202.254 - - [20/Jul/2009:22:59:27 +0000] "GET /splice/b0 HTTP/1.0" 200 134 "-" "gPXE/0.9.7"
+192.168.202.254 - - [20/Jul/2009:22:59:30 +0000] "GET /splice/b1 HTTP/1.0" 200 134 "-" "gPXE/0.9.7"
+192.168.202.254 - - [20/Jul/2009:22:59:32 +0000] "GET /splice/b2 HTTP/1.0" 200 134 "-" "gPXE/0.9.7"
+EOF
+
+run_test ${lnav_test} -n \
+    -c ":goto 0" \
+    -c ":mark" \
+    -c ":goto 4" \
+    -c ":mark" \
+    -c ":goto 0" \
+    -c ":filter-out vmkboot" \
+    -c ":adjust-log-time 2009-07-20T22:59:28" \
+    -c ":goto 0" \
+    ${test_dir}/logfile_access_log.0 \
+    logfile_splice.1
+
+check_output "adjust-log-time is not reordering one file among others" <<EOF
+192.168.202.254 - - [20/Jul/2009:22:59:27 +0000] "GET /splice/b0 HTTP/1.0" 200 134 "-" "gPXE/0.9.7"
+192.168.202.254 - - [20/Jul/2009:22:59:28 +0000] "GET /vmw/cgi/tramp HTTP/1.0" 200 134 "-" "gPXE/0.9.7"
+192.168.202.254 - - [20/Jul/2009:22:59:30 +0000] "GET /splice/b1 HTTP/1.0" 200 134 "-" "gPXE/0.9.7"
+192.168.202.254 - - [20/Jul/2009:22:59:31 +0000] "GET /vmw/vSphere/default/vmkernel.gz HTTP/1.0" 200 78929 "-" "gPXE/0.9.7"
+192.168.202.254 - - [20/Jul/2009:22:59:32 +0000] "GET /splice/b2 HTTP/1.0" 200 134 "-" "gPXE/0.9.7"
+EOF
+
+run_test ${lnav_test} -n \
+    -c ":goto 0" \
+    -c ":mark" \
+    -c ":goto 4" \
+    -c ":mark" \
+    -c ":goto 0" \
+    -c ":filter-out vmkboot" \
+    -c ":adjust-log-time 2009-07-20T22:59:28" \
+    -c ":hide-unmarked-lines" \
+    -c ":goto 0" \
+    ${test_dir}/logfile_access_log.0 \
+    logfile_splice.1
+
+check_output "bookmarks are not kept when one file is reordered" <<EOF
+192.168.202.254 - - [20/Jul/2009:22:59:28 +0000] "GET /vmw/cgi/tramp HTTP/1.0" 200 134 "-" "gPXE/0.9.7"
+192.168.202.254 - - [20/Jul/2009:22:59:30 +0000] "GET /splice/b1 HTTP/1.0" 200 134 "-" "gPXE/0.9.7"
+EOF
+
+
 run_test ${lnav_test} -n \
     -c ":goto 1" \
     ${test_dir}/logfile_access_log.0
@@ -977,6 +1022,46 @@ check_output "set-min-log-level is not working" <<EOF
 192.168.202.254 - - [20/Jul/2009:22:59:29 +0000] "GET /vmw/vSphere/default/vmkboot.gz HTTP/1.0" 404 46210 "-" "gPXE/0.9.7"
 EOF
 
+# Write lines <start> through <end> of a log that is long enough to fill
+# several summary blocks, one line per second with a couple of errors.
+gen_block_log() {
+    awk -v start=$1 -v end=$2 'BEGIN {
+        for (lpc = start; lpc <= end; lpc++) {
+            printf("2012-07-02 10:%02d:%02d,000:%s:block line %d\n",
+                   int(lpc / 60), lpc % 60,
+                   (lpc == 1500 || lpc == 3300) ? "ERROR" : "INFO", lpc);
+        }
+    }'
+}
+
+gen_block_log 0 3499 > logfile_blocks.0
+
+run_test ${lnav_test} -n \
+    -c ":set-min-log-level error" \
+    logfile_blocks.0
+
+check_output "set-min-log-level is not working across blocks" <<EOF
+2012-07-02 10:25:00,000:ERROR:block line 1500
+2012-07-02 10:55:00,000:ERROR:block line 3300
+EOF
+
+run_test ${lnav_test} -n \
+    -c ":hide-lines-before 2012-07-02T10:26:40" \
+    -c ":set-min-log-level error" \
+    logfile_blocks.0
+
+check_output "hide-lines-before is not working across blocks" <<EOF
+2012-07-02 10:55:00,000:ERROR:block line 3300
+EOF
+
+run_test ${lnav_test} -n \
+    -c ":hide-lines-before 2012-07-02T10:16:40" \
+    -c ":hide-lines-after 2012-07-02T10:51:39" \
+    logfile_blocks.0
+
+gen_block_log 1000 3099 | check_output \
+    "hide-lines-before/after is not working across blocks"
+
 run_test ${lnav_test} -n \
     -c ":highlight foobar" \
     -c ":clear-highlight foobar" \
@@ -164,6 +164,71 @@ main(int argc, char* argv[])
         assert(strcmp(ts, buf) == 0);
     }
 
+    {
+        static const char* SEQ_TIMES[] = {
+            "2014-02-11 16:12:34",
+            "2014-02-11 16:12:34.123",
+            "2014-02-11 16:13:05",
+            "2014-02-11 16:13:05 extra",
+            "2014-02-11 17:00:00",
+            "2014-02-12 17:00:59",
+        };
+        date_time_scanner memo_dts;
+
+        for (const auto* seq_time : SEQ_TIMES) {
+            date_time_scanner fresh_dts;
+            struct timeval memo_tv, fresh_tv;
+            struct exttm memo_tm, fresh_tm;
+
+            auto memo_rc = memo_dts.scan(
+                seq_time, strlen(seq_time), nullptr, &memo_tm, memo_tv);
+            auto fresh_rc = fresh_dts.scan(
+                seq_time, strlen(seq_time), nullptr, &fresh_tm, fresh_tv);
+            printf("memo %s\n", seq_time);
+            assert(memo_rc != nullptr);
+            assert(memo_rc == fresh_rc);
+            assert(memo_tv.tv_sec == fresh_tv.tv_sec);
+            assert(memo_tv.tv_usec == fresh_tv.tv_usec);
+            assert(memo_tm.et_tm.tm_min == fresh_tm.et_tm.tm_min);
+            assert(memo_tm.et_tm.tm_sec == fresh_tm.et_tm.tm_sec);
+            assert(memo_tm.et_flags == fresh_tm.et_flags);
+            assert(memo_dts.dts_fmt_len == fresh_dts.dts_fmt_len);
+        }
+    }
+
+    {
+        const char* fmt[] = {
+            "%d/%m/%Y %H:%M:%S",
+            nullptr,
+        };
+        static const char* SEQ_TIMES[] = {
+            "11/2/2014 16:12:34",
+            "11/2/2014 16:12:59",
+            "11/12/2014 16:12:34",
+            "11/12/2014 16:12:34,250",
+            "11/12/2014 16:12:34x",
+        };
+        date_time_scanner memo_dts;
+
+        for (const auto* seq_time : SEQ_TIMES) {
+            date_time_scanner fresh_dts;
+            struct timeval memo_tv, fresh_tv;
+            struct exttm memo_tm, fresh_tm;
+
+            auto memo_rc = memo_dts.scan(
+                seq_time, strlen(seq_time), fmt, &memo_tm, memo_tv);
+            auto fresh_rc = fresh_dts.scan(
+                seq_time, strlen(seq_time), fmt, &fresh_tm, fresh_tv);
+            printf("memo fmt %s\n", seq_time);
+            assert(memo_rc == fresh_rc);
+            if (fresh_rc == nullptr) {
+                continue;
+            }
+            assert(memo_tv.tv_sec == fresh_tv.tv_sec);
+            assert(memo_tv.tv_usec == fresh_tv.tv_usec);
+        }
+    }
+
     {
         const char* epoch_str = "ts 1428721664 ]";
         struct exttm tm;
@@ -57,6 +57,29 @@ check_output "Random reads don't match input?" <<EOF
 All done
 EOF
 
+if [ "$BZIP2_SUPPORT" -eq 1 ] && [ x"$BZIP2_CMD" != x"" ] ; then
+    $BZIP2_CMD -1 -c lb-2.dat > lb-2.dat.bz2
+
+    run_test ./drive_line_buffer -i lb.index -n 10 lb-2.dat.bz2 lb-2.dat
+
+    check_output "Random reads of a bzip2 file don't match input?" <<EOF
+All done
+EOF
+fi
+
+if [ "$ZSTD_SUPPORT" -eq 1 ] && [ x"$ZSTD_CMD" != x"" ] ; then
+    split -b 512k lb-2.dat lb-2.part.
+    for part in lb-2.part.*; do
+        $ZSTD_CMD -q -c "$part"
+    done > lb-2.dat.zst
+
+    run_test ./drive_line_buffer -i lb.index -n 10 lb-2.dat.zst lb-2.dat
+
+    check_output "Random reads of a zstd file don't match input?" <<EOF
+All done
+EOF
+fi
+
 gzip -c ${test_dir}/logfile_access_log.1 > lb-double.gz
 gzip -c ${test_dir}/logfile_access_log.1 >> lb-double.gz
 run_test ${lnav_test} -n lb-double.gz
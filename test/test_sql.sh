@@ -441,6 +441,19 @@ view_name,filter_id,hits
 log,1,2
 EOF
 
+# The queries are counted when they finish, so run one beforehand.
+run_test ${lnav_test} -n \
+    -c ";SELECT 1" \
+    -c ";SELECT name, count > 0 AS active FROM lnav_perf_stats WHERE name IN ('lines_indexed', 'sql_queries')" \
+    -c ":write-csv-to -" \
+    ${test_dir}/logfile_access_log.0
+
+check_output "perf stats are not working?" <<EOF
+name,active
+lines_indexed,1
+sql_queries,1
+EOF
+
 run_test ${lnav_test} -n \
     -c ";INSERT INTO lnav_view_filters (view_name, language, pattern) VALUES ('log', 'sql', ':sc_bytes = 134')" \
     ${test_dir}/logfile_access_log.0
@@ -1101,7 +1114,7 @@ EOF
 
 
 schema_dump() {
-    ${lnav_test} -n -c ';.schema' ${test_dir}/logfile_access_log.0 | head -n19
+    ${lnav_test} -n -c ';.schema' ${test_dir}/logfile_access_log.0 | head -n20
 }
 
 run_test schema_dump
@@ -1115,6 +1128,7 @@ CREATE VIRTUAL TABLE lnav_view_files USING lnav_view_files_impl();
 CREATE VIRTUAL TABLE lnav_view_stack USING lnav_view_stack_impl();
 CREATE VIRTUAL TABLE lnav_view_filters USING lnav_view_filters_impl();
 CREATE VIRTUAL TABLE lnav_file USING lnav_file_impl();
+CREATE VIRTUAL TABLE lnav_perf_stats USING lnav_perf_stats_impl();
 CREATE VIEW lnav_view_filters_and_stats AS
   SELECT * FROM lnav_view_filters LEFT NATURAL JOIN lnav_view_filter_stats;
 CREATE VIRTUAL TABLE regexp_capture USING regexp_capture_impl();
@@ -0,0 +1,74 @@
+#! /bin/bash
+
+if ! command -v python3 > /dev/null 2>&1; then
+    exit 0
+fi
+
+rm -f url_loader_port.tmp url_loader_requests.tmp
+python3 ${test_dir}/http_fixture.py \
+    url_loader_port.tmp url_loader_requests.tmp &
+fixture_pid=$!
+trap "kill ${fixture_pid} 2> /dev/null" EXIT
+
+for lpc in 1 2 3 4 5 6 7 8 9 10; do
+    test -f url_loader_port.tmp && break
+    sleep 1
+done
+
+if ! test -f url_loader_port.tmp; then
+    echo "HTTP fixture did not start"
+    exit 1
+fi
+
+fixture_url="http://127.0.0.1:`cat url_loader_port.tmp`"
+
+run_test ./drive_url_loader -p 3 ${fixture_url}/grow.log
+
+check_output "Range resume is not appending the new data?" <<EOF
+line 0
+line 1
+line 2
+line 3
+EOF
+
+run_test ./drive_url_loader -p 3 ${fixture_url}/norange.log
+
+check_output "200 reply to a Range request is not skipping the prefix?" <<EOF
+line 0
+line 1
+line 2
+line 3
+EOF
+
+run_test ./drive_url_loader -p 3 ${fixture_url}/samesec.log
+
+check_output "lines appended in the same second are not fetched?" <<EOF
+line 0
+line 1
+line 2
+line 3
+EOF
+
+run_test ./drive_url_loader -p 3 ${fixture_url}/static.log
+
+check_output "304 reply is changing the fetched data?" <<EOF
+static line 0
+static line 1
+EOF
+
+run_test cat url_loader_requests.tmp
+
+check_output "url_loader is not sending the right conditions?" <<EOF
+/grow.log range=no ims=no inm=no 200
+/grow.log range=yes ims=no inm=yes 206
+/grow.log range=yes ims=no inm=yes 206
+/norange.log range=no ims=no inm=no 200
+/norange.log range=yes ims=no inm=yes 200
+/norange.log range=yes ims=no inm=yes 200
+/samesec.log range=no ims=no inm=no 200
+/samesec.log range=yes ims=no inm=yes 206
+/samesec.log range=yes ims=no inm=yes 206
+/static.log range=no ims=no inm=no 200
+/static.log range=yes ims=no inm=yes 304
+/static.log range=yes ims=no inm=yes 304
+EOF